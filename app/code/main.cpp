@@ -17,6 +17,10 @@
 
 #include <fstream>
 
+#ifdef PEN_PLATFORM_IOS
+#include <os/proc.h>
+#endif
+
 #include "maths/maths.h"
 
 using namespace put;
@@ -114,796 +118,3368 @@ namespace curl
     }
 }
 
-u32 get_tags(nlohmann::json& tags)
+// thread pool
+
+static ThreadPool s_thread_pool;
+
+struct WorkerParams
+{
+    ThreadPool* pool;
+    u32         index;
+};
+
+bool pool_pop(ThreadPool& pool, u32 worker, Task& task)
 {
-    u32 t = 0;
-    for(size_t i = 0; i < PEN_ARRAY_SIZE(Tags::names); ++i)
+    // highest priority first, own queue from the front then steal from the back of others
+    for(u32 p = 0; p < TaskPriority::count; ++p)
     {
-        auto& name = Tags::names[i];
-            
-        if(tags.contains(name))
+        for(u32 w = 0; w < pool.num_workers; ++w)
         {
-            if(tags[name])
+            u32 victim = (worker + w) % pool.num_workers;
+            WorkerQueue& queue = pool.workers[victim];
+            
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            auto& tasks = queue.tasks[p];
+            if(tasks.empty())
             {
-                t |= (1<<i);
+                continue;
+            }
+            
+            if(victim == worker)
+            {
+                task = tasks.front();
+                tasks.pop_front();
             }
+            else
+            {
+                task = tasks.back();
+                tasks.pop_back();
+            }
+            
+            pool.queued--;
+            return true;
         }
     }
     
-    return t;
+    return false;
 }
 
-Str get_tags_str(u32 tags)
+void* pool_worker(void* userdata)
 {
-    Str tag_str = "";
-    bool first = true;
-    for(size_t i = 0; i < PEN_ARRAY_SIZE(Tags::names); ++i)
+    WorkerParams* params = (WorkerParams*)userdata;
+    ThreadPool& pool = *params->pool;
+    u32 worker = params->index;
+    
+    for(;;)
     {
-        if(tags & 1<<i)
+        Task task;
+        if(pool_pop(pool, worker, task))
         {
-            if(!first)
+            task.function(task.user, task.index);
+            if(task.counter)
             {
-                tag_str.append(" / ");
+                (*task.counter)--;
             }
-            
-            tag_str.append(Tags::names[i]);
-            first = false;
+            continue;
         }
+        
+        // sleep until work is submitted
+        std::unique_lock<std::mutex> lock(pool.sleep_mutex);
+        pool.sleep_cv.wait(lock, [&pool]() { return pool.queued > 0; });
     }
     
-    return tag_str;
+    return nullptr;
 }
 
-u32 tag_menu(u32 tags)
+void pool_init(ThreadPool& pool)
 {
-    for(size_t i = 0; i < PEN_ARRAY_SIZE(Tags::names); ++i)
+    u32 num_workers = std::max<u32>(2, std::thread::hardware_concurrency());
+    
+    pool.workers = new WorkerQueue[num_workers];
+    pool.num_workers = num_workers;
+    
+    WorkerParams* params = new WorkerParams[num_workers];
+    for(u32 i = 0; i < num_workers; ++i)
     {
-        bool selected = tags & 1<<i;
-        ImGui::Checkbox(Tags::names[i], &selected);
-        
-        if(selected)
-        {
-            tags |= (1<<i);
-        }
-        else
-        {
-            tags &= ~(1<<i);
-        }
+        params[i] = { &pool, i };
+        pen::thread_create(pool_worker, 10 * 1024 * 1024, &params[i], pen::e_thread_start_flags::detached);
     }
-    
-    return tags;
 }
 
-// TODO: make more user data centric
-static nlohmann::json   s_likes;
-static std::mutex       s_like_mutex;
-static bool             s_likes_invalidated = false;
-
-nlohmann::json get_likes()
+void pool_submit(ThreadPool& pool, TaskPriority_t priority, TaskFunction function, void* user, u32 index, std::atomic<u32>* counter = nullptr)
 {
-    s_like_mutex.lock();
-    auto cp = s_likes;
-    s_like_mutex.unlock();
-    return cp;
+    Task task;
+    task.function = function;
+    task.user = user;
+    task.index = index;
+    task.counter = counter;
+    
+    if(counter)
+    {
+        (*counter)++;
+    }
+    
+    // counted before the task is visible, so a worker popping it can never take queued below zero
+    {
+        std::lock_guard<std::mutex> lock(pool.sleep_mutex);
+        pool.queued++;
+    }
+    
+    u32 worker = pool.next_worker++ % pool.num_workers;
+    {
+        std::lock_guard<std::mutex> lock(pool.workers[worker].mutex);
+        pool.workers[worker].tasks[priority].push_back(task);
+    }
+    pool.sleep_cv.notify_one();
 }
 
-bool has_like(Str id)
+u32 get_dictionary_id(StringDictionary& dict, const std::string& name, u32 limit)
 {
-    bool ret = false;
-    s_like_mutex.lock();
-    if(s_likes.contains(id.c_str()))
+    std::lock_guard<std::mutex> lock(dict.mutex);
+    
+    auto it = dict.lookup.find(name);
+    if(it != dict.lookup.end())
     {
-        ret = s_likes[id.c_str()];
+        return it->second;
     }
-    s_like_mutex.unlock();
-    return ret;
+    
+    u32 id = (u32)dict.names.size();
+    if(id >= limit)
+    {
+        PEN_LOG("dictionary limit reached, ignoring: %s", name.c_str());
+        return limit;
+    }
+    
+    dict.lookup[name] = id;
+    dict.names.push_back(name);
+    return id;
 }
 
-void add_like(Str id)
+TagBits get_tags(StringDictionary& dict, nlohmann::json& release)
 {
-    s_like_mutex.lock();
-    s_likes[id.c_str()] = true;
-    s_like_mutex.unlock();
-    s_likes_invalidated = true;
+    TagBits t = {};
+    
+    // legacy tags object
+    if(release.contains("tags"))
+    {
+        auto& tags = release["tags"];
+        for(size_t i = 0; i < PEN_ARRAY_SIZE(Tags::names); ++i)
+        {
+            auto& name = Tags::names[i];
+            if(tags.contains(name) && tags[name].is_boolean() && tags[name])
+            {
+                u32 id = get_dictionary_id(dict, name, k_max_genre_tags);
+                if(id < k_max_genre_tags)
+                {
+                    t.words[id / 64] |= (1ull << (id % 64));
+                }
+            }
+        }
+    }
+    
+    // loose genre tags
+    for(auto& item : release.items())
+    {
+        if(item.value().is_string() && item.value() == "genre_tag")
+        {
+            u32 id = get_dictionary_id(dict, item.key(), k_max_genre_tags);
+            if(id < k_max_genre_tags)
+            {
+                t.words[id / 64] |= (1ull << (id % 64));
+            }
+        }
+    }
+    
+    return t;
 }
 
-void remove_like(Str id)
+inline bool tag_test(const TagBits& tags, u32 id)
 {
-    s_like_mutex.lock();
-    s_likes.erase(id.c_str());
-    s_like_mutex.unlock();
-    s_likes_invalidated = true;
+    return tags.words[id / 64] & (1ull << (id % 64));
 }
 
-generic_cmp_array& get_component_array(soa& s, size_t i)
+inline bool tag_bits_empty(const TagBits& tags)
 {
-    generic_cmp_array* begin = (generic_cmp_array*)&s;
-    return begin[i];
+    u64 r = 0;
+    for(u32 w = 0; w < k_tag_words; ++w)
+    {
+        r |= tags.words[w];
+    }
+    return r == 0;
 }
 
-size_t get_num_components(soa& s)
+// an empty filter matches everything, otherwise match any of the selected tags
+inline bool tag_bits_match(const TagBits& tags, const TagBits& filter)
 {
-    generic_cmp_array* begin = (generic_cmp_array*)&s;
-    generic_cmp_array* end = (generic_cmp_array*)&s.available_entries;
-    return (size_t)(end - begin);
+    u64 any = 0;
+    u64 all = 0;
+    for(u32 w = 0; w < k_tag_words; ++w)
+    {
+        any |= tags.words[w] & filter.words[w];
+        all |= filter.words[w];
+    }
+    return any || !all;
 }
 
-void resize_components(soa& s, size_t size)
+Str get_tags_str(StringDictionary& dict, const TagBits& tags)
 {
-    size_t new_size = s.soa_size + size;
-
-    size_t num = get_num_components(s);
-    for (u32 i = 0; i < num; ++i)
+    if(tag_bits_empty(tags))
     {
-        generic_cmp_array& cmp = get_component_array(s, i);
-        size_t alloc_size = cmp.size * new_size;
-
-        if (cmp.data)
+        return "all";
+    }
+    
+    Str tag_str = "";
+    bool first = true;
+    
+    std::lock_guard<std::mutex> lock(dict.mutex);
+    for(u32 i = 0; i < (u32)dict.names.size(); ++i)
+    {
+        if(tag_test(tags, i))
         {
-            // realloc
-            cmp.data = pen::memory_realloc(cmp.data, alloc_size);
-
-            // zero new mem
-            size_t prev_size = s.soa_size * cmp.size;
-            u8* new_offset = (u8*)cmp.data + prev_size;
-            size_t zero_size = alloc_size - prev_size;
-            pen::memory_zero(new_offset, zero_size);
-
-            continue;
+            if(!first)
+            {
+                tag_str.append(" / ");
+            }
+            
+            tag_str.append(dict.names[i].c_str());
+            first = false;
         }
-
-        // alloc and zero
-        cmp.data = pen::memory_alloc(alloc_size);
-        pen::memory_zero(cmp.data, alloc_size);
     }
-
-    s.soa_size = new_size;
+    
+    return tag_str;
 }
 
-void free_components(soa& s)
+// counts how many releases carry each tag, by walking only the set bits of each release
+void count_tags(const soa_column<TagBits>& genre_tags, size_t begin, size_t end, std::vector<u32>& counts)
 {
-    size_t num = get_num_components(s);
-    for (u32 i = 0; i < num; ++i)
+    counts.resize(k_max_genre_tags, 0);
+    
+    for(size_t i = begin; i < end; ++i)
     {
-        generic_cmp_array& cmp = get_component_array(s, i);
-        pen::memory_free(cmp.data);
+        for(u32 w = 0; w < k_tag_words; ++w)
+        {
+            u64 bits = genre_tags[i].words[w];
+            while(bits)
+            {
+                u32 b = (u32)__builtin_ctzll(bits);
+                counts[w * 64 + b]++;
+                bits &= bits - 1;
+            }
+        }
     }
 }
 
-Str get_cache_path()
-{
-    Str dir = os_get_cache_data_directory();
-    dir.appendf("/dig/cache/");
-    return dir;
-}
-
-Str get_docs_path()
-{
-    Str dir = os_get_persistent_data_directory();
-    dir.appendf("/dig/");
-    return dir;
-}
-
-Str download_and_cache(const Str& url, Str releaseid)
+TagBits tag_menu(StringDictionary& dict, const TagBits& tags, const std::vector<u32>& counts)
 {
-    Str filepath = pen::str_replace_string(url, "https://", "");
-    filepath = pen::str_replace_chars(filepath, '/', '_');
-    
-    Str dir = get_cache_path();
-    dir.appendf("/%s", releaseid.c_str());
-    
-    // filepath
-    Str path = dir;
-    path.appendf("/%s", filepath.c_str());
-    filepath = path;
+    TagBits new_tags = tags;
     
-    // check if file already exists
-    u32 mtime = 0;
-    pen::filesystem_getmtime(filepath.c_str(), mtime);
-    if(mtime == 0)
+    std::lock_guard<std::mutex> lock(dict.mutex);
+    for(u32 i = 0; i < (u32)dict.names.size(); ++i)
     {
-        // mkdirs
-        pen::os_create_directory(dir.c_str());
-        
-        // download
-        auto db = new curl::DataBuffer;
-        *db = curl::download(url.c_str());
+        // only show tags which are present in this view
+        if(i >= counts.size() || counts[i] == 0)
+        {
+            continue;
+        }
         
-        // stash
-        FILE* fp = fopen(filepath.c_str(), "wb");
-        fwrite(db->data, db->size, 1, fp);
-        fclose(fp);
+        bool selected = tag_test(tags, i);
+        Str label;
+        label.appendf("%s (%u)", dict.names[i].c_str(), counts[i]);
+        ImGui::Checkbox(label.c_str(), &selected);
         
-        // free
-        free(db->data);
+        if(selected)
+        {
+            new_tags.words[i / 64] |= (1ull << (i % 64));
+        }
+        else
+        {
+            new_tags.words[i / 64] &= ~(1ull << (i % 64));
+        }
     }
     
-    return filepath;
+    return new_tags;
 }
 
-Str download_and_cache_named(const Str& url, const Str& filename)
+Str get_filter_str(DataContext& data_ctx, const FilterState& filter)
 {
-    Str dir = os_get_persistent_data_directory();
-    dir.appendf("/dig");
+    Str filter_str = "";
+    auto append = [&filter_str](const c8* name) {
+        if(filter_str.length() > 0)
+        {
+            filter_str.append(" / ");
+        }
+        filter_str.append(name);
+    };
     
-    // filepath
-    Str path = dir;
-    path.appendf("/%s", filename.c_str());
-    Str filepath = path;
+    {
+        std::lock_guard<std::mutex> lock(data_ctx.stores.mutex);
+        for(u32 i = 0; i < (u32)data_ctx.stores.names.size(); ++i)
+        {
+            if(filter.stores & (1ull << i))
+            {
+                append(data_ctx.stores.names[i].c_str());
+            }
+        }
+    }
     
-    // check if file already exists
-    u32 mtime = 0;
-    pen::filesystem_getmtime(filepath.c_str(), mtime);
-    if(mtime == 0)
+    if(filter.exclude & StoreTags::out_of_stock)
     {
-        // mkdirs
-        pen::os_create_directory(dir.c_str());
+        append("in stock");
     }
-        
-    // download
-    auto db = new curl::DataBuffer;
-    *db = curl::download(url.c_str());
     
-    // stash
-    FILE* fp = fopen(filepath.c_str(), "wb");
-    fwrite(db->data, db->size, 1, fp);
-    fclose(fp);
+    for(u32 t = 0; t < PEN_ARRAY_SIZE(StoreTags::names); ++t)
+    {
+        if(filter.require & (1<<t))
+        {
+            append(StoreTags::names[t]);
+        }
+    }
     
-    // free
-    free(db->data);
+    if(filter.label != k_no_label)
+    {
+        std::lock_guard<std::mutex> lock(data_ctx.labels.mutex);
+        if(filter.label < data_ctx.labels.names.size())
+        {
+            append(data_ctx.labels.names[filter.label].c_str());
+        }
+    }
     
-    return filepath;
-}
-
-pen::texture_creation_params load_texture_from_disk(const Str& filepath)
-{
-    s32 w, h, c;
-    stbi_uc* rgba = stbi_load(filepath.c_str(), &w, &h, &c, 4);
+    if(filter.liked)
+    {
+        append("liked");
+    }
     
-    c = 4;
+    if(filter_str.length() == 0)
+    {
+        filter_str = "no filter";
+    }
     
-    pen::texture_creation_params tcp;
-    tcp.width = w;
-    tcp.height = h;
-    tcp.format = PEN_TEX_FORMAT_RGBA8_UNORM;
-    tcp.data = rgba;
-    tcp.sample_count = 1;
-    tcp.sample_quality = 0;
-    tcp.num_arrays = 1;
-    tcp.num_mips = 1;
-    tcp.collection_type = 0;
-    tcp.bind_flags = 0;
-    tcp.usage = PEN_USAGE_DEFAULT;
-    tcp.bind_flags = PEN_BIND_SHADER_RESOURCE;
-    tcp.cpu_access_flags = 0;
-    tcp.flags = 0;
-    tcp.block_size = 4;
-    tcp.pixels_per_block = 1;
-    tcp.collection_type = pen::TEXTURE_COLLECTION_NONE;
-    tcp.data = rgba;
-    tcp.data_size = w * h * c;
-
-    return tcp;
+    return filter_str;
 }
 
-void* registry_loader(void* userdata)
+FilterState filter_menu(DataContext& data_ctx, const FilterState& filter)
 {
-    DataContext* ctx = (DataContext*)userdata;
-    
-    // construct registry path
-    Str reg_path = get_docs_path();
-    reg_path.append("registry.json");
+    FilterState new_filter = filter;
     
-    // first we can check if we have a cached registry
-    ctx->cache_registry_status = DataStatus::e_loading;
-        
-    u32 mtime = 0;
-    pen::filesystem_getmtime(reg_path.c_str(), mtime);
-    if(mtime != 0)
+    // stores
     {
-        ctx->registry_mutex.lock();
-        try {
-            ctx->registry = nlohmann::json::parse(std::ifstream(reg_path.c_str()));
-            ctx->cache_registry_status = DataStatus::e_ready;
-        } 
+        std::lock_guard<std::mutex> lock(data_ctx.stores.mutex);
+        for(u32 i = 0; i < (u32)data_ctx.stores.names.size(); ++i)
+        {
+            bool selected = filter.stores & (1ull << i);
+            ImGui::Checkbox(data_ctx.stores.names[i].c_str(), &selected);
+            
+            if(selected)
+            {
+                new_filter.stores |= (1ull << i);
+            }
+            else
+            {
+                new_filter.stores &= ~(1ull << i);
+            }
+        }
+    }
+    
+    // store tags
+    bool in_stock = filter.exclude & StoreTags::out_of_stock;
+    ImGui::Checkbox("in stock", &in_stock);
+    new_filter.exclude = in_stock ? StoreTags::out_of_stock : 0;
+    
+    constexpr StoreTags_t k_require_tags[] = {
+        StoreTags::preorder,
+        StoreTags::has_charted
+    };
+    
+    for(auto tag : k_require_tags)
+    {
+        u32 t = (u32)__builtin_ctz(tag);
+        bool selected = filter.require & tag;
+        ImGui::Checkbox(StoreTags::names[t], &selected);
+        
+        if(selected)
+        {
+            new_filter.require |= tag;
+        }
+        else
+        {
+            new_filter.require &= ~tag;
+        }
+    }
+    
+    // likes
+    ImGui::Checkbox("liked", &new_filter.liked);
+    
+    // label is selected by tapping a release label in the feed
+    if(filter.label != k_no_label)
+    {
+        std::lock_guard<std::mutex> lock(data_ctx.labels.mutex);
+        if(filter.label < data_ctx.labels.names.size())
+        {
+            Str label = "";
+            label.appendf("%s %s", ICON_FA_TIMES, data_ctx.labels.names[filter.label].c_str());
+            if(ImGui::MenuItem(label.c_str()))
+            {
+                new_filter.label = k_no_label;
+            }
+        }
+    }
+    
+    return new_filter;
+}
+
+// filter query engine: each node evaluates to a bitmap over a range of entries, 1 bit per release
+
+template<typename Pred>
+void bitmap_kernel(size_t begin, size_t count, u64* out, Pred pred)
+{
+    size_t num_words = (count + 63) / 64;
+    for(size_t w = 0; w < num_words; ++w)
+    {
+        size_t base = begin + w * 64;
+        size_t n = std::min<size_t>(64, count - w * 64);
+        
+        u64 bits = 0;
+        for(size_t b = 0; b < n; ++b)
+        {
+            bits |= (u64)pred(base + b) << b;
+        }
+        out[w] = bits;
+    }
+}
+
+void bitmap_select(const u64* bits, size_t num_words, size_t begin, std::vector<u32>& selection)
+{
+    for(size_t w = 0; w < num_words; ++w)
+    {
+        u64 word = bits[w];
+        while(word)
+        {
+            u32 b = (u32)__builtin_ctzll(word);
+            selection.push_back((u32)(begin + w * 64 + b));
+            word &= word - 1;
+        }
+    }
+}
+
+u32 query_add(Query& q, const QueryNode& node)
+{
+    q.nodes.push_back(node);
+    return (u32)q.nodes.size() - 1;
+}
+
+u32 query_and(Query& q, u32 lhs, u32 rhs)
+{
+    QueryNode node;
+    node.op = QueryOp::op_and;
+    node.lhs = lhs;
+    node.rhs = rhs;
+    return query_add(q, node);
+}
+
+Query build_query(const FilterState& filter)
+{
+    Query q;
+    
+    QueryNode all;
+    all.op = QueryOp::all;
+    u32 root = query_add(q, all);
+    
+    if(!tag_bits_empty(filter.tags))
+    {
+        QueryNode node;
+        node.op = QueryOp::tags_any;
+        node.tags = filter.tags;
+        root = query_and(q, root, query_add(q, node));
+    }
+    
+    if(filter.stores)
+    {
+        QueryNode node;
+        node.op = QueryOp::store_in;
+        node.value = filter.stores;
+        root = query_and(q, root, query_add(q, node));
+    }
+    
+    if(filter.require)
+    {
+        QueryNode node;
+        node.op = QueryOp::store_tags_all;
+        node.value = filter.require;
+        root = query_and(q, root, query_add(q, node));
+    }
+    
+    if(filter.exclude)
+    {
+        QueryNode node;
+        node.op = QueryOp::store_tags_none;
+        node.value = filter.exclude;
+        root = query_and(q, root, query_add(q, node));
+    }
+    
+    if(filter.label != k_no_label)
+    {
+        QueryNode node;
+        node.op = QueryOp::label_id;
+        node.value = filter.label;
+        root = query_and(q, root, query_add(q, node));
+    }
+    
+    if(filter.liked)
+    {
+        QueryNode node;
+        node.op = QueryOp::flags_any;
+        node.value = EntryFlags::liked;
+        root = query_and(q, root, query_add(q, node));
+    }
+    
+    return q;
+}
+
+// evaluates the query over entries [begin, end) and appends passing indices to selection
+void evaluate_query(const Query& q, soa& s, size_t begin, size_t end, std::vector<u32>& selection)
+{
+    if(q.nodes.empty() || end <= begin)
+    {
+        return;
+    }
+    
+    size_t count = end - begin;
+    size_t num_words = (count + 63) / 64;
+    u64 tail_mask = (count % 64) ? ((1ull << (count % 64)) - 1) : ~0ull;
+    
+    static std::vector<u64> s_bitmaps;
+    s_bitmaps.resize(q.nodes.size() * num_words);
+    
+    for(size_t n = 0; n < q.nodes.size(); ++n)
+    {
+        const QueryNode& node = q.nodes[n];
+        u64* out = &s_bitmaps[n * num_words];
+        const u64* lhs = &s_bitmaps[node.lhs * num_words];
+        const u64* rhs = &s_bitmaps[node.rhs * num_words];
+        
+        switch(node.op)
+        {
+            case QueryOp::all:
+                for(size_t w = 0; w < num_words; ++w) {
+                    out[w] = ~0ull;
+                }
+                out[num_words-1] = tail_mask;
+                break;
+            case QueryOp::op_and:
+                for(size_t w = 0; w < num_words; ++w) {
+                    out[w] = lhs[w] & rhs[w];
+                }
+                break;
+            case QueryOp::op_or:
+                for(size_t w = 0; w < num_words; ++w) {
+                    out[w] = lhs[w] | rhs[w];
+                }
+                break;
+            case QueryOp::op_not:
+                for(size_t w = 0; w < num_words; ++w) {
+                    out[w] = ~lhs[w];
+                }
+                out[num_words-1] &= tail_mask;
+                break;
+            case QueryOp::tags_any:
+            {
+                const TagBits* tags = s.genre_tags.data;
+                const TagBits& mask = node.tags;
+                bitmap_kernel(begin, count, out, [tags, &mask](size_t i) {
+                    u64 any = 0;
+                    for(u32 t = 0; t < k_tag_words; ++t) {
+                        any |= tags[i].words[t] & mask.words[t];
+                    }
+                    return any != 0;
+                });
+                break;
+            }
+            case QueryOp::store_tags_all:
+            {
+                const StoreTags_t* tags = s.store_tags.data;
+                StoreTags_t mask = (StoreTags_t)node.value;
+                bitmap_kernel(begin, count, out, [tags, mask](size_t i) {
+                    return (tags[i] & mask) == mask;
+                });
+                break;
+            }
+            case QueryOp::store_tags_none:
+            {
+                const StoreTags_t* tags = s.store_tags.data;
+                StoreTags_t mask = (StoreTags_t)node.value;
+                bitmap_kernel(begin, count, out, [tags, mask](size_t i) {
+                    return (tags[i] & mask) == 0;
+                });
+                break;
+            }
+            case QueryOp::store_in:
+            {
+                const u64* stores = s.store_mask.data;
+                u64 mask = node.value;
+                bitmap_kernel(begin, count, out, [stores, mask](size_t i) {
+                    return (stores[i] & mask) != 0;
+                });
+                break;
+            }
+            case QueryOp::label_id:
+            {
+                const u32* ids = s.label_id.data;
+                u32 id = (u32)node.value;
+                bitmap_kernel(begin, count, out, [ids, id](size_t i) {
+                    return ids[i] == id;
+                });
+                break;
+            }
+            case QueryOp::flags_any:
+            {
+                const u64* flags = s.flags.data;
+                u64 mask = node.value;
+                bitmap_kernel(begin, count, out, [flags, mask](size_t i) {
+                    return (flags[i] & mask) != 0;
+                });
+                break;
+            }
+        }
+    }
+    
+    bitmap_select(&s_bitmaps[(q.nodes.size() - 1) * num_words], num_words, begin, selection);
+}
+
+// TODO: make more user data centric
+static nlohmann::json   s_likes;
+static std::mutex       s_like_mutex;
+static std::condition_variable s_likes_cv;
+static bool             s_likes_invalidated = false;
+
+nlohmann::json get_likes()
+{
+    s_like_mutex.lock();
+    auto cp = s_likes;
+    s_like_mutex.unlock();
+    return cp;
+}
+
+bool has_like(Str id)
+{
+    bool ret = false;
+    s_like_mutex.lock();
+    if(s_likes.contains(id.c_str()))
+    {
+        ret = s_likes[id.c_str()];
+    }
+    s_like_mutex.unlock();
+    return ret;
+}
+
+void add_like(Str id)
+{
+    s_like_mutex.lock();
+    s_likes[id.c_str()] = true;
+    s_likes_invalidated = true;
+    s_like_mutex.unlock();
+    s_likes_cv.notify_one();
+}
+
+void remove_like(Str id)
+{
+    s_like_mutex.lock();
+    s_likes.erase(id.c_str());
+    s_likes_invalidated = true;
+    s_like_mutex.unlock();
+    s_likes_cv.notify_one();
+}
+
+struct column_reserve_func
+{
+    size_t count;
+    
+    template<typename T>
+    void operator()(soa_column<T>& col)
+    {
+        column_reserve(col, count);
+    }
+};
+
+struct column_free_func
+{
+    template<typename T>
+    void operator()(soa_column<T>& col)
+    {
+        column_free(col);
+    }
+};
+
+void reserve_components(soa& s, size_t size)
+{
+    // only called before entries are made available, columns already large enough are left alone
+    size_t new_size = s.soa_size + size;
+    
+    column_reserve_func reserve = { new_size };
+    s.visit(reserve);
+    
+    s.soa_size = new_size;
+}
+
+void free_components(soa& s)
+{
+    column_free_func free_func;
+    s.visit(free_func);
+    s.soa_size = 0;
+}
+
+// counts live arena blocks and staging buffers across all views, should return to zero once views are freed
+static std::atomic<s64> s_view_allocations = { 0 };
+
+s64 live_view_allocations()
+{
+    return s_view_allocations;
+}
+
+void* arena_alloc(ViewArena& arena, size_t size, size_t align)
+{
+    std::lock_guard<std::mutex> lock(arena.mutex);
+    
+    // bump from the current block if it fits
+    ArenaBlock* block = arena.blocks;
+    if(block)
+    {
+        size_t offset = (block->used + align - 1) & ~(align - 1);
+        if(offset + size <= block->size)
+        {
+            block->used = offset + size;
+            return (u8*)(block + 1) + offset;
+        }
+    }
+    
+    // new block, oversized requests get a block of their own
+    size_t block_size = std::max<size_t>(64 * 1024, size + align);
+    block = (ArenaBlock*)pen::memory_alloc(sizeof(ArenaBlock) + block_size);
+    block->next = arena.blocks;
+    block->size = block_size;
+    block->used = 0;
+    arena.blocks = block;
+    arena.bytes += block_size;
+    s_view_allocations++;
+    
+    size_t offset = (((size_t)(block + 1) + align - 1) & ~(align - 1)) - (size_t)(block + 1);
+    block->used = offset + size;
+    return (u8*)(block + 1) + offset;
+}
+
+template<typename T>
+void arena_destruct(void* ptr, size_t count)
+{
+    T* elems = (T*)ptr;
+    for(size_t i = 0; i < count; ++i) {
+        elems[i].~T();
+    }
+}
+
+template<typename T>
+T* arena_new(ViewArena& arena, size_t count)
+{
+    T* elems = (T*)arena_alloc(arena, sizeof(T) * count, alignof(T));
+    for(size_t i = 0; i < count; ++i) {
+        new(&elems[i]) T();
+    }
+    
+    // types which own memory of their own need their destructors run on release
+    if(!std::is_trivially_destructible<T>::value)
+    {
+        std::lock_guard<std::mutex> lock(arena.mutex);
+        arena.destructors.push_back({ arena_destruct<T>, elems, count });
+    }
+    
+    return elems;
+}
+
+void arena_release(ViewArena& arena)
+{
+    for(auto& d : arena.destructors) {
+        d.destruct(d.ptr, d.count);
+    }
+    arena.destructors.clear();
+    arena.bytes = 0;
+    
+    while(arena.blocks)
+    {
+        ArenaBlock* next = arena.blocks->next;
+        pen::memory_free(arena.blocks);
+        arena.blocks = next;
+        s_view_allocations--;
+    }
+}
+
+SharedBytes* take_downloaded(soa& releases, size_t i)
+{
+    SharedBytes* bytes = releases.artwork_bytes[i].exchange(nullptr);
+    if(bytes) {
+        releases.staging_bytes -= bytes->size;
+    }
+    return bytes;
+}
+
+void release_bytes(SharedBytes* bytes)
+{
+    if(bytes && --bytes->refs == 0)
+    {
+        free(bytes->data);
+        delete bytes;
+    }
+}
+
+void byte_cache_remove(ByteCache& cache, std::map<std::string, ByteCacheEntry>::iterator it)
+{
+    // caller holds the lock
+    cache.bytes -= it->second.bytes->size;
+    release_bytes(it->second.bytes);
+    cache.lru.erase(it->second.lru);
+    cache.entries.erase(it);
+}
+
+void byte_cache_trim(ByteCache& cache, size_t budget)
+{
+    // caller holds the lock, least recently used go first
+    while(cache.bytes > budget && !cache.lru.empty()) {
+        byte_cache_remove(cache, cache.entries.find(cache.lru.back()));
+    }
+}
+
+void byte_cache_insert_locked(ByteCache& cache, SharedBytes* bytes)
+{
+    auto it = cache.entries.find(bytes->filepath.c_str());
+    if(it != cache.entries.end()) {
+        byte_cache_remove(cache, it);
+    }
+    
+    bytes->refs++;
+    cache.lru.push_front(bytes->filepath.c_str());
+    
+    auto& entry = cache.entries[bytes->filepath.c_str()];
+    entry.bytes = bytes;
+    entry.lru = cache.lru.begin();
+    cache.bytes += bytes->size;
+    
+    byte_cache_trim(cache, cache.budget);
+}
+
+void byte_cache_insert(ByteCache& cache, SharedBytes* bytes)
+{
+    // replaces any entry for the same path, used for bytes which are what is being written to disk
+    if(!bytes || bytes->size > cache.budget) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    byte_cache_insert_locked(cache, bytes);
+}
+
+void byte_cache_erase(ByteCache& cache, const Str& filepath)
+{
+    // writers call this when a file is rewritten, so readers go back to disk
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.generation++;
+    
+    auto it = cache.entries.find(filepath.c_str());
+    if(it != cache.entries.end()) {
+        byte_cache_remove(cache, it);
+    }
+}
+
+SharedBytes* read_cached(ByteCache& cache, const Str& filepath)
+{
+    // returns a reference the caller must release, or null if the file does not exist
+    u32 generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        auto it = cache.entries.find(filepath.c_str());
+        if(it != cache.entries.end())
+        {
+            cache.hits++;
+            cache.lru.splice(cache.lru.begin(), cache.lru, it->second.lru);
+            it->second.bytes->refs++;
+            return it->second.bytes;
+        }
+        cache.misses++;
+        generation = cache.generation;
+    }
+    
+    FILE* fp = fopen(filepath.c_str(), "rb");
+    if(!fp) {
+        return nullptr;
+    }
+    
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    
+    SharedBytes* bytes = new SharedBytes;
+    bytes->filepath = filepath;
+    bytes->size = size > 0 ? (size_t)size : 0;
+    bytes->data = (u8*)malloc(bytes->size + 1);
+    if(bytes->size == 0 || fread(bytes->data, bytes->size, 1, fp) != 1)
+    {
+        fclose(fp);
+        release_bytes(bytes);
+        return nullptr;
+    }
+    fclose(fp);
+    
+    // a file rewritten while we were reading may have been read half written, keep it out of the cache
+    if(bytes->size <= cache.budget)
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        if(cache.generation == generation) {
+            byte_cache_insert_locked(cache, bytes);
+        }
+    }
+    return bytes;
+}
+
+void stash_downloaded(soa& releases, size_t i, SharedBytes* bytes)
+{
+    if(bytes) {
+        releases.staging_bytes += bytes->size;
+    }
+    release_bytes(take_downloaded(releases, i));
+    releases.artwork_bytes[i] = bytes;
+}
+
+void free_staging(soa& releases, size_t i)
+{
+    // downloaded bytes which never reached the decoder, the disk write holds its own reference
+    release_bytes(take_downloaded(releases, i));
+    
+    auto& tcp = releases.artwork_tcp[i];
+    if(tcp.data)
+    {
+        pen::memory_free(tcp.data);
+        tcp.data = nullptr;
+        releases.staging_bytes -= tcp.data_size;
+        s_view_allocations--;
+    }
+}
+
+Str get_cache_path()
+{
+    Str dir = os_get_cache_data_directory();
+    dir.appendf("/dig/cache/");
+    return dir;
+}
+
+Str get_docs_path()
+{
+    Str dir = os_get_persistent_data_directory();
+    dir.appendf("/dig/");
+    return dir;
+}
+
+std::string normalise_key(const std::string& str)
+{
+    std::string key;
+    key.reserve(str.length());
+    for(auto c : str)
+    {
+        if(isalnum((u8)c))
+        {
+            key.push_back((c8)tolower((u8)c));
+        }
+    }
+    return key;
+}
+
+std::string get_dedupe_key(DedupeIndex& index, nlohmann::json& release)
+{
+    std::string id = release["id"];
+    
+    std::lock_guard<std::mutex> lock(index.mutex);
+    
+    // releases found to share artwork with another release link to it
+    auto alias = index.aliases.find(id);
+    if(alias != index.aliases.end())
+    {
+        return alias->second;
+    }
+    
+    // without label / cat a release keys on its own id, so it can still be the target of an alias
+    std::string key = "id:" + id;
+    if(release.contains("label") && release.contains("cat") && release["cat"].is_string())
+    {
+        std::string cat = normalise_key(release["cat"]);
+        if(!cat.empty())
+        {
+            key = normalise_key(release["label"]);
+            key.append(":");
+            key.append(cat);
+        }
+    }
+    
+    if(release.contains("artist") && release["artist"].is_string()) {
+        index.artists[id] = normalise_key(release["artist"]);
+    }
+    
+    if(release.contains("title") && release["title"].is_string()) {
+        index.titles[id] = normalise_key(release["title"]);
+    }
+    
+    if(release.contains("store") && release["store"].is_string()) {
+        index.stores[id] = release["store"];
+    }
+    
+    index.keys[id] = key;
+    return key;
+}
+
+bool register_artwork_signature(DedupeIndex& index, const std::string& id, const ArtworkSignature& sig)
+{
+    // re-encodes differ byte for byte between stores, so artwork is matched on its signature quantised to 4 bits a channel
+    u32 lo[3] = { 255, 255, 255 };
+    u32 hi[3] = { 0, 0, 0 };
+    u64 quantised = 0;
+    for(u32 c = 0; c < 4; ++c)
+    {
+        for(u32 ch = 0; ch < 3; ++ch)
+        {
+            u32 v = (sig.corners[c] >> (ch * 8)) & 0xff;
+            lo[ch] = std::min(lo[ch], v);
+            hi[ch] = std::max(hi[ch], v);
+            quantised = (quantised << 4) | (v >> 4);
+        }
+    }
+    
+    // no signature yet, or flat artwork (plain sleeves, white labels) which says nothing about the record
+    if(sig.corners[0] == 0 || (hi[0] - lo[0] < 32 && hi[1] - lo[1] < 32 && hi[2] - lo[2] < 32)) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(index.mutex);
+    
+    auto key = index.keys.find(id);
+    if(key == index.keys.end() || index.aliases.count(id)) {
+        return false;
+    }
+    
+    auto existing = index.artworks.find(quantised);
+    if(existing == index.artworks.end())
+    {
+        index.artworks[quantised] = id;
+        return false;
+    }
+    
+    auto other_key = index.keys.find(existing->second);
+    if(other_key == index.keys.end() || other_key->second == key->second) {
+        return false;
+    }
+    
+    // templated sleeves and compilations share artist and colours, so the artwork alone is not enough.
+    // only the same artist and title from a different store is the same record, a store never lists a record twice
+    auto same = [&index, &id, &existing](const std::map<std::string, std::string>& field) {
+        auto a = field.find(id);
+        auto b = field.find(existing->second);
+        return a != field.end() && b != field.end() && !a->second.empty() && a->second == b->second;
+    };
+    
+    auto store = index.stores.find(id);
+    auto other_store = index.stores.find(existing->second);
+    if(store == index.stores.end() || other_store == index.stores.end() || store->second == other_store->second) {
+        return false;
+    }
+    
+    if(same(index.artists) && same(index.titles))
+    {
+        index.aliases[id] = other_key->second;
+        return true;
+    }
+    
+    return false;
+}
+
+StoreTags_t get_store_tags(nlohmann::json& release)
+{
+    StoreTags_t tags = 0;
+    if(release.contains("store_tags"))
+    {
+        for(u32 t = 0; t < PEN_ARRAY_SIZE(StoreTags::names); ++t) {
+            if(release["store_tags"].contains(StoreTags::names[t]) && release["store_tags"][StoreTags::names[t]])
+            {
+                tags |= (1<<t);
+            }
+        }
+    }
+    return tags;
+}
+
+u32 get_store_id(DataContext* ctx, nlohmann::json& release)
+{
+    if(release.contains("store"))
+    {
+        return get_dictionary_id(ctx->stores, release["store"], k_max_stores);
+    }
+    return k_max_stores;
+}
+
+// moving averages of artwork bandwidth and decode time, used to size the request windows and pick artwork lods
+static std::atomic<u32> s_artwork_bytes_per_ms = { 0 };
+static std::atomic<u32> s_decode_ms = { 0 };
+
+void update_average(std::atomic<u32>& average, u32 sample)
+{
+    u32 prev = average;
+    average = prev == 0 ? sample : (prev * 7 + sample) / 8;
+}
+
+Str temp_path(const Str& filepath)
+{
+    // unique per write, so concurrent writers of the same file never share a temp file
+    static std::atomic<u32> s_temp_counter = { 0 };
+    Str tmp = filepath;
+    tmp.appendf(".part%u", s_temp_counter++);
+    return tmp;
+}
+
+void write_downloaded(void* userdata, u32)
+{
+    SharedBytes* bytes = (SharedBytes*)userdata;
+    
+    // written aside and renamed so the cache never sees a partial file
+    Str tmp = temp_path(bytes->filepath);
+    FILE* fp = fopen(tmp.c_str(), "wb");
+    if(fp)
+    {
+        bool written = fwrite(bytes->data, bytes->size, 1, fp) == 1;
+        fclose(fp);
+        
+        if(!written || rename(tmp.c_str(), bytes->filepath.c_str()) != 0) {
+            remove(tmp.c_str());
+        }
+    }
+    
+    release_bytes(bytes);
+}
+
+Str download_and_cache(const Str& url, Str releaseid, SharedBytes** downloaded = nullptr)
+{
+    Str filepath = pen::str_replace_string(url, "https://", "");
+    filepath = pen::str_replace_chars(filepath, '/', '_');
+    
+    Str dir = get_cache_path();
+    dir.appendf("/%s", releaseid.c_str());
+    
+    // filepath
+    Str path = dir;
+    path.appendf("/%s", filepath.c_str());
+    filepath = path;
+    
+    // check if file already exists
+    u32 mtime = 0;
+    pen::filesystem_getmtime(filepath.c_str(), mtime);
+    if(mtime == 0)
+    {
+        // mkdirs
+        pen::os_create_directory(dir.c_str());
+        
+        // download
+        u32 download_start = pen::get_time_ms();
+        curl::DataBuffer db = curl::download(url.c_str());
+        u32 download_ms = std::max<u32>(pen::get_time_ms() - download_start, 1);
+        
+        if(!db.data) {
+            return filepath;
+        }
+        
+        // only artwork (callers taking the bytes) is measured, several snippets per release would swamp it
+        if(downloaded) {
+            update_average(s_artwork_bytes_per_ms, std::max<u32>((u32)(db.size / download_ms), 1));
+        }
+        
+        SharedBytes* bytes = new SharedBytes;
+        bytes->data = db.data;
+        bytes->size = db.size;
+        bytes->filepath = filepath;
+        
+        // callers taking the bytes decode from memory while the write happens in the background,
+        // others (snippets) open the file straight after so it is written before we return
+        if(downloaded)
+        {
+            bytes->refs++;
+            *downloaded = bytes;
+            pool_submit(s_thread_pool, TaskPriority::maintenance, write_downloaded, bytes, 0);
+        }
+        else
+        {
+            write_downloaded(bytes, 0);
+        }
+    }
+    
+    return filepath;
+}
+
+Str download_and_cache_named(const Str& url, const Str& filename)
+{
+    Str dir = os_get_persistent_data_directory();
+    dir.appendf("/dig");
+    
+    // filepath
+    Str path = dir;
+    path.appendf("/%s", filename.c_str());
+    Str filepath = path;
+    
+    // check if file already exists
+    u32 mtime = 0;
+    pen::filesystem_getmtime(filepath.c_str(), mtime);
+    if(mtime == 0)
+    {
+        // mkdirs
+        pen::os_create_directory(dir.c_str());
+    }
+        
+    // download
+    curl::DataBuffer db = curl::download(url.c_str());
+    
+    // stash
+    FILE* fp = fopen(filepath.c_str(), "wb");
+    fwrite(db.data, db.size, 1, fp);
+    fclose(fp);
+    
+    // free
+    free(db.data);
+    
+    return filepath;
+}
+
+pen::texture_creation_params artwork_params(s32 w, s32 h, void* rgba)
+{
+    pen::texture_creation_params tcp;
+    tcp.width = w;
+    tcp.height = h;
+    tcp.format = PEN_TEX_FORMAT_RGBA8_UNORM;
+    tcp.data = rgba;
+    tcp.sample_count = 1;
+    tcp.sample_quality = 0;
+    tcp.num_arrays = 1;
+    tcp.num_mips = 1;
+    tcp.collection_type = 0;
+    tcp.bind_flags = 0;
+    tcp.usage = PEN_USAGE_DEFAULT;
+    tcp.bind_flags = PEN_BIND_SHADER_RESOURCE;
+    tcp.cpu_access_flags = 0;
+    tcp.flags = 0;
+    tcp.block_size = 4;
+    tcp.pixels_per_block = 1;
+    tcp.collection_type = pen::TEXTURE_COLLECTION_NONE;
+    tcp.data = rgba;
+    tcp.data_size = w * h * 4;
+
+    return tcp;
+}
+
+// area average resample of rgba8, each destination pixel is the box of source pixels it covers
+u8* resample_rgba(const u8* src, s32 sw, s32 sh, s32 dw, s32 dh)
+{
+    u8* dst = (u8*)pen::memory_alloc(dw * dh * 4);
+    
+    // 16.16 fixed point steps through the source
+    u32 step_x = (u32)(((u64)sw << 16) / dw);
+    u32 step_y = (u32)(((u64)sh << 16) / dh);
+    
+    for(s32 y = 0; y < dh; ++y)
+    {
+        s32 y0 = (s32)(((u64)y * step_y) >> 16);
+        s32 y1 = std::max(y0 + 1, std::min((s32)((((u64)y + 1) * step_y) >> 16), sh));
+        
+        for(s32 x = 0; x < dw; ++x)
+        {
+            s32 x0 = (s32)(((u64)x * step_x) >> 16);
+            s32 x1 = std::max(x0 + 1, std::min((s32)((((u64)x + 1) * step_x) >> 16), sw));
+            
+            // plain loops over contiguous channels so the compiler can vectorise them
+            u32 sum[4] = { 0, 0, 0, 0 };
+            for(s32 sy = y0; sy < y1; ++sy)
+            {
+                const u8* p = src + ((size_t)sy * sw + x0) * 4;
+                for(s32 sx = x0; sx < x1; ++sx, p += 4)
+                {
+                    sum[0] += p[0];
+                    sum[1] += p[1];
+                    sum[2] += p[2];
+                    sum[3] += p[3];
+                }
+            }
+            
+            u32 count = (u32)((y1 - y0) * (x1 - x0));
+            u8* d = dst + ((size_t)y * dw + x) * 4;
+            for(u32 c = 0; c < 4; ++c) {
+                d[c] = (u8)((sum[c] + count / 2) / count);
+            }
+        }
+    }
+    
+    return dst;
+}
+
+pen::texture_creation_params fit_artwork(stbi_uc* rgba, s32 w, s32 h, u32 target_width)
+{
+    if(!rgba) {
+        return artwork_params(0, 0, nullptr);
+    }
+    
+    // the stbi buffer never escapes, artwork pixels are always pen allocations freed with pen::memory_free
+    u8* pixels = nullptr;
+    
+    // decode straight to display size, artwork is never drawn larger than the feed width
+    if(target_width > 0 && (u32)w > target_width)
+    {
+        s32 tw = (s32)target_width;
+        s32 th = std::max<s32>(1, (s32)(((s64)h * tw) / w));
+        
+        pixels = resample_rgba(rgba, w, h, tw, th);
+        w = tw;
+        h = th;
+    }
+    else
+    {
+        pixels = (u8*)pen::memory_alloc((size_t)w * h * 4);
+        memcpy(pixels, rgba, (size_t)w * h * 4);
+    }
+    
+    stbi_image_free(rgba);
+    return artwork_params(w, h, pixels);
+}
+
+pen::texture_creation_params load_texture_from_disk(const Str& filepath, u32 target_width)
+{
+    s32 w, h, c;
+    stbi_uc* rgba = stbi_load(filepath.c_str(), &w, &h, &c, 4);
+    return fit_artwork(rgba, w, h, target_width);
+}
+
+pen::texture_creation_params load_texture_from_memory(const u8* data, size_t size, u32 target_width)
+{
+    s32 w, h, c;
+    stbi_uc* rgba = stbi_load_from_memory(data, (s32)size, &w, &h, &c, 4);
+    return fit_artwork(rgba, w, h, target_width);
+}
+
+void info_loader(void* userdata, u32);
+
+void set_data_status(DataContext* ctx, std::atomic<u32>& status, u32 value)
+{
+    std::vector<ReleasesView*> waiters;
+    {
+        std::lock_guard<std::mutex> lock(ctx->status_mutex);
+        status = value;
+        
+        if(&status == &ctx->cache_registry_status && value == DataStatus::e_ready) {
+            waiters.swap(ctx->registry_waiters);
+        }
+    }
+    ctx->status_cv.notify_all();
+    
+    // views parked waiting on the registry continue on the pool, and drop the reference they held while parked
+    for(auto& view : waiters)
+    {
+        pool_submit(s_thread_pool, TaskPriority::fetch, info_loader, view, 0, &view->pending_tasks);
+        view->pending_tasks--;
+    }
+}
+
+std::string read_registry(const Str& reg_path)
+{
+    std::ifstream f(reg_path.c_str(), std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+}
+
+void bump_registry_version(DataContext* ctx, const std::string& contents)
+{
+    // reloading an unchanged registry keeps the version, so cached views built from it stay reusable
+    size_t hash = std::hash<std::string>()(contents);
+    if(ctx->registry_version == 0 || hash != ctx->registry_hash)
+    {
+        ctx->registry_hash = hash;
+        ctx->registry_version++;
+    }
+}
+
+void* registry_loader(void* userdata)
+{
+    DataContext* ctx = (DataContext*)userdata;
+    
+    // construct registry path
+    Str reg_path = get_docs_path();
+    reg_path.append("registry.json");
+    
+    // first we can check if we have a cached registry
+    set_data_status(ctx, ctx->cache_registry_status, DataStatus::e_loading);
+        
+    u32 mtime = 0;
+    pen::filesystem_getmtime(reg_path.c_str(), mtime);
+    if(mtime != 0)
+    {
+        ctx->registry_mutex.lock();
+        try {
+            std::string contents = read_registry(reg_path);
+            ctx->registry = nlohmann::json::parse(contents);
+            ctx->registry_bytes = contents.size();
+            bump_registry_version(ctx, contents);
+            set_data_status(ctx, ctx->cache_registry_status, DataStatus::e_ready);
+        } 
         catch(...) {
-            ctx->cache_registry_status = DataStatus::e_loading;
+            set_data_status(ctx, ctx->cache_registry_status, DataStatus::e_loading);
+        }
+        ctx->registry_mutex.unlock();
+    }
+    
+    for(;;)
+    {
+        // grab the latest
+        set_data_status(ctx, ctx->latest_registry_status, DataStatus::e_loading);
+        download_and_cache_named("https://raw.githubusercontent.com/polymonster/dig/main/registry/releases.json", "registry.json");
+        
+        std::string contents = read_registry(reg_path);
+        nlohmann::json reg = nlohmann::json::parse(contents);
+        
+        ctx->registry_bytes = contents.size();
+        set_data_status(ctx, ctx->latest_registry_status, DataStatus::e_ready);
+        
+        ctx->registry_mutex.lock();
+        ctx->registry = reg;
+        bump_registry_version(ctx, contents);
+        set_data_status(ctx, ctx->cache_registry_status, DataStatus::e_ready);
+        ctx->registry_mutex.unlock();
+
+        // sleep until a view requests a new registry
+        {
+            std::unique_lock<std::mutex> lock(ctx->status_mutex);
+            ctx->status_cv.wait(lock, [ctx]() { return ctx->latest_registry_status != DataStatus::e_ready; });
+        }
+        
+        PEN_LOG("fetch new reg");
+    }
+};
+
+void* user_data_thread(void* userdata)
+{
+    // get user data dir
+    Str user_data_dir = os_get_persistent_data_directory();
+    user_data_dir.append("/dig/user_data/");
+    
+    // create dir
+    pen::os_create_directory(user_data_dir);
+    
+    // grab likes
+    u32 mtime  = 0;
+    Str likes_filepath = user_data_dir;
+    likes_filepath.appendf("likes.json");
+    pen::filesystem_getmtime(likes_filepath.c_str(), mtime);
+    if(mtime)
+    {
+        std::ifstream f(likes_filepath.c_str());
+        s_likes = nlohmann::json::parse(f);;
+    }
+
+    for(;;)
+    {
+        // sleep until likes change
+        std::unique_lock<std::mutex> lock(s_like_mutex);
+        s_likes_cv.wait(lock, []() { return s_likes_invalidated; });
+        
+        auto likes_str = s_likes.dump();
+        s_likes_invalidated = false;
+        lock.unlock();
+        
+        FILE* fp = fopen(likes_filepath.c_str(), "w");
+        fwrite(likes_str.c_str(), likes_str.length(), 1, fp);
+        fclose(fp);
+    }
+}
+
+void info_loader(void* userdata, u32)
+{
+    // get view from userdata
+    ReleasesView* view = (ReleasesView*)userdata;
+    DataContext* data_ctx = view->data_ctx;
+    
+    // park until the cached registry is ready instead of blocking a pool worker, set_data_status resubmits us
+    {
+        std::lock_guard<std::mutex> lock(data_ctx->status_mutex);
+        if(data_ctx->cache_registry_status != DataStatus::e_ready)
+        {
+            view->pending_tasks++;
+            data_ctx->registry_waiters.push_back(view);
+            return;
+        }
+    }
+    
+    if(view->reg_timeout > 1000)
+    {
+        set_data_status(data_ctx, data_ctx->latest_registry_status, DataStatus::e_loading);
+    }
+    
+    // grab registry; either latest or cached
+    nlohmann::json releases_registry;
+    
+    view->data_ctx->registry_mutex.lock();
+    releases_registry = view->data_ctx->registry;
+    view->registry_version = view->data_ctx->registry_version;
+    view->data_ctx->registry_mutex.unlock();
+    
+    // grab items for this requested view from the registry
+    std::vector<ChartItem> view_chart;
+    std::string view_name = View::lookup_names[view->view];
+    
+    if(view->view == View::likes)
+    {
+        for(auto& like : s_likes.items())
+        {
+            if(releases_registry.contains(like.key()) && like.value())
+            {
+                view_chart.push_back({
+                    like.key(),
+                    0
+                });
+            }
+        }
+    }
+    else
+    {
+        // populate view
+        for(auto& item : releases_registry)
+        {
+            if(item.contains(view_name))
+            {
+                view_chart.push_back({
+                    item["id"],
+                    item[view_name]
+                });
+            }
+        }
+    }
+    
+    // sort the items
+    std::sort(begin(view_chart),end(view_chart),[](ChartItem a, ChartItem b) {return a.pos < b.pos; });
+    
+    // group equivalent releases from different stores, the first in view order becomes the card
+    std::vector<std::vector<std::string>> view_groups;
+    std::map<std::string, size_t> group_lookup;
+    for(auto& entry : view_chart)
+    {
+        auto& release = releases_registry[entry.index];
+        std::string key = get_dedupe_key(view->data_ctx->dedupe, release);
+        
+        // artwork signatures from previous sessions can link releases before anything is decoded
+        ArtworkSignature sig = {};
+        {
+            auto& index = view->data_ctx->signatures;
+            std::lock_guard<std::mutex> lock(index.mutex);
+            auto it = index.signatures.find(entry.index);
+            if(it != index.signatures.end()) {
+                sig = it->second;
+            }
+        }
+        
+        if(register_artwork_signature(view->data_ctx->dedupe, entry.index, sig)) {
+            key = get_dedupe_key(view->data_ctx->dedupe, release);
+        }
+        
+        auto it = group_lookup.find(key);
+        if(it != group_lookup.end())
+        {
+            view_groups[it->second].push_back(entry.index);
+            continue;
+        }
+        group_lookup[key] = view_groups.size();
+        
+        view_groups.push_back({entry.index});
+    }
+    
+    // make space
+    reserve_components(view->releases, view_groups.size());
+    
+    for(auto& group : view_groups)
+    {
+        u32 ri = (u32)view->releases.available_entries;
+        auto release = releases_registry[group[0]];
+        
+        // simple info
+        view->releases.artist[ri] = release["artist"];
+        view->releases.title[ri] = release["title"];
+        view->releases.link[ri] = release["link"];
+        view->releases.label[ri] = release["label"];
+        view->releases.cat[ri] = release["cat"];
+        
+        // clear
+        view->releases.artwork_filepath[ri] = "";
+        view->releases.artwork_slot[ri] = 0;
+        view->releases.flags[ri] = 0;
+        view->releases.track_name_count[ri] = 0;
+        view->releases.track_names[ri] = nullptr;
+        view->releases.track_url_count[ri] = 0;
+        view->releases.track_urls[ri] = nullptr;
+        view->releases.track_filepath_count[ri] = 0;
+        view->releases.select_track[ri] = 0; // reset
+        view->releases.genre_tags[ri] = get_tags(view->data_ctx->genre_tags, release);
+        view->releases.label_id[ri] = get_dictionary_id(view->data_ctx->labels, release["label"], k_no_label);
+        view->releases.store_id[ri] = get_store_id(view->data_ctx, release);
+        view->releases.store_tags[ri] = get_store_tags(release);
+        view->releases.store_mask[ri] = 0;
+        view->releases.store_link_count[ri] = 0;
+        view->releases.store_links[ri] = nullptr;
+        
+        if(view->releases.store_id[ri] < k_max_stores)
+        {
+            view->releases.store_mask[ri] |= 1ull << view->releases.store_id[ri];
+        }
+        
+        // links to the same release in other stores, assets are only fetched for the card
+        if(group.size() > 1)
+        {
+            u32 link_count = (u32)group.size() - 1;
+            view->releases.store_links[ri] = arena_new<StoreLink>(view->arena, link_count);
+            for(u32 l = 0; l < link_count; ++l)
+            {
+                auto other = releases_registry[group[l + 1]];
+                auto& store_link = view->releases.store_links[ri][l];
+                store_link.id = other["id"].get<std::string>().c_str();
+                store_link.link = other["link"];
+                store_link.store_id = get_store_id(view->data_ctx, other);
+                store_link.store_tags = get_store_tags(other);
+                
+                if(store_link.store_id < k_max_stores)
+                {
+                    view->releases.store_mask[ri] |= 1ull << store_link.store_id;
+                }
+                
+                // a like on any of the linked releases counts
+                if(other.contains("id") && has_like(other["id"].get<std::string>().c_str()))
+                {
+                    view->releases.flags[ri] |= EntryFlags::liked;
+                }
+            }
+            
+            std::atomic_thread_fence(std::memory_order_release);
+            view->releases.store_link_count[ri] = link_count;
+        }
+        memset(&view->releases.artwork_tcp[ri], 0x0, sizeof(pen::texture_creation_params));
+        view->releases.artwork_size[ri] = ArtworkSize();
+        
+        std::string id = release["id"];
+        view->releases.id[ri] = id.c_str();
+        
+        // placeholder from a previous decode
+        {
+            auto& index = view->data_ctx->signatures;
+            std::lock_guard<std::mutex> lock(index.mutex);
+            auto sig = index.signatures.find(id);
+            view->releases.artwork_signature[ri] = sig != index.signatures.end() ? sig->second : ArtworkSignature();
+        }
+
+        // assign artwork urls, the smallest available loads first and is upgraded once on screen
+        u32 artwork_count = std::min<u32>((u32)release["artworks"].size(), ArtworkLod::count);
+        for(u32 l = 0; l < ArtworkLod::count; ++l)
+        {
+            view->releases.artwork_urls[ri].lod[l] = "";
+        }
+        for(u32 l = 0; l < artwork_count; ++l)
+        {
+            view->releases.artwork_urls[ri].lod[l] = release["artworks"][l];
+        }
+        
+        view->releases.artwork_lod[ri] = ArtworkLod::thumb;
+        view->releases.artwork_url[ri] = "";
+        for(u32 l = 0; l < artwork_count; ++l)
+        {
+            if(!view->releases.artwork_urls[ri].lod[l].empty())
+            {
+                view->releases.artwork_lod[ri] = l;
+                view->releases.artwork_url[ri] = view->releases.artwork_urls[ri].lod[l];
+                break;
+            }
+        }
+
+        // track names
+        u32 name_count = (u32)release["track_names"].size();
+        if(name_count > 0)
+        {
+            view->releases.track_names[ri] = arena_new<Str>(view->arena, name_count);
+            for(u32 t = 0; t < release["track_names"].size(); ++t)
+            {
+                view->releases.track_names[ri][t] = release["track_names"][t];
+            }
+            
+            std::atomic_thread_fence(std::memory_order_release);
+            view->releases.track_name_count[ri] = name_count;
+        }
+
+        // track urls
+        u32 url_count = (u32)release["track_urls"].size();
+        if(url_count > 0)
+        {
+            view->releases.track_urls[ri] = arena_new<Str>(view->arena, url_count);
+            for(u32 t = 0; t < release["track_urls"].size(); ++t)
+            {
+                view->releases.track_urls[ri][t] = release["track_urls"][t];
+            }
+            
+            std::atomic_thread_fence(std::memory_order_release);
+            view->releases.track_url_count[ri] = url_count;
+        }
+        
+        // check likes
+        if(has_like(view->releases.id[ri]))
+        {
+            view->releases.flags[ri] |= EntryFlags::liked;
+        }
+        
+        view->releases.available_entries++;
+    }
+}
+
+bool state_transition(std::atomic<EntryState_t>& state, EntryState_t from, EntryState_t to)
+{
+    return state.compare_exchange_strong(from, to, std::memory_order_acq_rel);
+}
+
+void push_state_change(ReleasesView* view, u32 index, EntryState_t state)
+{
+    std::lock_guard<std::mutex> lock(view->state_changes.mutex);
+    view->state_changes.changes.push_back({index, state});
+}
+
+size_t get_folder_size_recursive(const pen::fs_tree_node& dir, const c8* root)
+{
+    size_t size = 0;
+    for(u32 i = 0; i < dir.num_children; ++i)
+    {
+        Str path = "";
+        path.appendf("%s/%s", root, dir.children[i].name);
+        
+        if(dir.children[i].num_children > 0)
+        {
+            size += get_folder_size_recursive(dir.children[i], path.c_str());
+        }
+        else
+        {
+            size += filesystem_getsize(path.c_str());
+        }
+    }
+    
+    return size;
+}
+
+Str get_signature_index_path()
+{
+    Str path = os_get_cache_data_directory();
+    path.appendf("/dig/artwork_index.json");
+    return path;
+}
+
+ArtworkSignature compute_signature(const pen::texture_creation_params& tcp)
+{
+    // average each quadrant, pixels are rgba8 which packs straight into imgui's abgr colours
+    ArtworkSignature sig = {};
+    const u8* rgba = (const u8*)tcp.data;
+    u32 w = tcp.width;
+    u32 h = tcp.height;
+    u32 hw = std::max<u32>(w / 2, 1);
+    u32 hh = std::max<u32>(h / 2, 1);
+    
+    static const u32 k_quadrant[4][2] = { {0, 0}, {1, 0}, {1, 1}, {0, 1} };
+    for(u32 q = 0; q < 4; ++q)
+    {
+        u32 x0 = std::min(k_quadrant[q][0] * hw, w - 1);
+        u32 y0 = std::min(k_quadrant[q][1] * hh, h - 1);
+        u32 x1 = std::min(x0 + hw, w);
+        u32 y1 = std::min(y0 + hh, h);
+        
+        // strided so large artwork costs the same as a thumbnail
+        u32 step = std::max<u32>(1, hw / 16);
+        u32 sum[3] = { 0, 0, 0 };
+        u32 count = 0;
+        for(u32 y = y0; y < y1; y += step)
+        {
+            for(u32 x = x0; x < x1; x += step)
+            {
+                const u8* p = rgba + ((size_t)y * w + x) * 4;
+                sum[0] += p[0];
+                sum[1] += p[1];
+                sum[2] += p[2];
+                count++;
+            }
+        }
+        
+        count = std::max<u32>(count, 1);
+        sig.corners[q] = (sum[0] / count) | ((sum[1] / count) << 8) | ((sum[2] / count) << 16) | (0xffu << 24);
+    }
+    
+    return sig;
+}
+
+bool signature_valid(const ArtworkSignature& sig)
+{
+    // alpha is always written as opaque
+    return sig.corners[0] != 0;
+}
+
+void load_signature_index(SignatureIndex& index)
+{
+    Str path = get_signature_index_path();
+    u32 mtime = 0;
+    pen::filesystem_getmtime(path.c_str(), mtime);
+    if(mtime == 0) {
+        return;
+    }
+    
+    try {
+        nlohmann::json j = nlohmann::json::parse(std::ifstream(path.c_str()));
+        std::lock_guard<std::mutex> lock(index.mutex);
+        for(auto& item : j.items())
+        {
+            ArtworkSignature sig;
+            for(u32 c = 0; c < 4; ++c) {
+                sig.corners[c] = item.value()[c];
+            }
+            index.signatures[item.key()] = sig;
+        }
+    }
+    catch(...) {
+        PEN_LOG("failed to load artwork index");
+    }
+}
+
+void save_signature_index(void* userdata, u32)
+{
+    SignatureIndex& index = *(SignatureIndex*)userdata;
+    
+    nlohmann::json j;
+    {
+        std::lock_guard<std::mutex> lock(index.mutex);
+        for(auto& entry : index.signatures)
+        {
+            auto& c = entry.second.corners;
+            j[entry.first] = { c[0], c[1], c[2], c[3] };
+        }
+    }
+    
+    // written aside and renamed, a crash mid write must not lose the index loaded next launch
+    auto str = j.dump();
+    Str path = get_signature_index_path();
+    Str tmp = temp_path(path);
+    FILE* fp = fopen(tmp.c_str(), "w");
+    if(fp)
+    {
+        bool written = fwrite(str.c_str(), str.length(), 1, fp) == 1;
+        fclose(fp);
+        
+        if(!written || rename(tmp.c_str(), path.c_str()) != 0) {
+            remove(tmp.c_str());
+        }
+    }
+}
+
+// block compression, artwork is encoded once to bc1 and the blocks are cached next to the source image
+#ifdef PEN_PLATFORM_IOS
+constexpr bool k_compress_artwork = false; // no bc support on ios gpus, astc / etc2 would be needed here
+#else
+constexpr bool k_compress_artwork = true;
+#endif
+
+struct CompressedHeader
+{
+    u32 magic;
+    u32 width;
+    u32 height;
+    u32 source_width;
+    u32 source_height;
+    u32 target_width;
+    u32 data_size;
+};
+
+constexpr u32 k_bc1_magic = 0x32434244; // DBC2, bumped when the header changes
+
+u16 pack_565(const u8* rgb)
+{
+    return (u16)(((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3));
+}
+
+void unpack_565(u16 c, u8* rgb)
+{
+    u8 r = (c >> 11) & 0x1f;
+    u8 g = (c >> 5) & 0x3f;
+    u8 b = c & 0x1f;
+    rgb[0] = (u8)((r << 3) | (r >> 2));
+    rgb[1] = (u8)((g << 2) | (g >> 4));
+    rgb[2] = (u8)((b << 3) | (b >> 2));
+}
+
+void bc1_palette(u16 c0, u16 c1, u8 palette[4][3])
+{
+    unpack_565(c0, palette[0]);
+    unpack_565(c1, palette[1]);
+    for(u32 c = 0; c < 3; ++c)
+    {
+        palette[2][c] = (u8)((2 * palette[0][c] + palette[1][c]) / 3);
+        palette[3][c] = (u8)((palette[0][c] + 2 * palette[1][c]) / 3);
+    }
+}
+
+void encode_bc1_block(const u8 block[16][4], u8* out)
+{
+    // range fit along the bounding box diagonal, inset slightly to reduce error at the extremes
+    u8 lo[3] = { 255, 255, 255 };
+    u8 hi[3] = { 0, 0, 0 };
+    for(u32 p = 0; p < 16; ++p)
+    {
+        for(u32 c = 0; c < 3; ++c)
+        {
+            lo[c] = std::min(lo[c], block[p][c]);
+            hi[c] = std::max(hi[c], block[p][c]);
+        }
+    }
+    
+    for(u32 c = 0; c < 3; ++c)
+    {
+        u8 inset = (u8)((hi[c] - lo[c]) / 16);
+        lo[c] += inset;
+        hi[c] -= inset;
+    }
+    
+    u16 c0 = pack_565(hi);
+    u16 c1 = pack_565(lo);
+    
+    // c0 > c1 selects the 4 colour mode
+    u32 indices = 0;
+    if(c0 != c1)
+    {
+        if(c0 < c1) {
+            std::swap(c0, c1);
         }
-        ctx->registry_mutex.unlock();
+        
+        u8 palette[4][3];
+        bc1_palette(c0, c1, palette);
+        for(u32 p = 0; p < 16; ++p)
+        {
+            u32 best = 0;
+            s32 best_dist = 0x7fffffff;
+            for(u32 e = 0; e < 4; ++e)
+            {
+                s32 dr = (s32)block[p][0] - palette[e][0];
+                s32 dg = (s32)block[p][1] - palette[e][1];
+                s32 db = (s32)block[p][2] - palette[e][2];
+                s32 dist = dr * dr + dg * dg + db * db;
+                if(dist < best_dist)
+                {
+                    best = e;
+                    best_dist = dist;
+                }
+            }
+            indices |= best << (p * 2);
+        }
+    }
+    
+    memcpy(out, &c0, 2);
+    memcpy(out + 2, &c1, 2);
+    memcpy(out + 4, &indices, 4);
+}
+
+u8* encode_bc1(const u8* rgba, u32 w, u32 h, u32& data_size)
+{
+    // edge blocks clamp to the last row and column
+    u32 bw = (w + 3) / 4;
+    u32 bh = (h + 3) / 4;
+    data_size = bw * bh * 8;
+    u8* blocks = (u8*)pen::memory_alloc(data_size);
+    
+    u8 block[16][4];
+    for(u32 by = 0; by < bh; ++by)
+    {
+        for(u32 bx = 0; bx < bw; ++bx)
+        {
+            for(u32 p = 0; p < 16; ++p)
+            {
+                u32 x = std::min(bx * 4 + (p % 4), w - 1);
+                u32 y = std::min(by * 4 + (p / 4), h - 1);
+                memcpy(block[p], rgba + ((size_t)y * w + x) * 4, 4);
+            }
+            
+            encode_bc1_block(block, blocks + (by * bw + bx) * 8);
+        }
+    }
+    
+    return blocks;
+}
+
+void decode_bc1(const u8* blocks, u32 w, u32 h, u8* rgba)
+{
+    u32 bw = (w + 3) / 4;
+    u32 bh = (h + 3) / 4;
+    for(u32 by = 0; by < bh; ++by)
+    {
+        for(u32 bx = 0; bx < bw; ++bx)
+        {
+            const u8* b = blocks + (by * bw + bx) * 8;
+            u16 c0, c1;
+            u32 indices;
+            memcpy(&c0, b, 2);
+            memcpy(&c1, b + 2, 2);
+            memcpy(&indices, b + 4, 4);
+            
+            u8 palette[4][3];
+            bc1_palette(c0, c1, palette);
+            for(u32 p = 0; p < 16; ++p)
+            {
+                u32 x = bx * 4 + (p % 4);
+                u32 y = by * 4 + (p / 4);
+                if(x >= w || y >= h) {
+                    continue;
+                }
+                
+                u8* d = rgba + ((size_t)y * w + x) * 4;
+                memcpy(d, palette[(indices >> (p * 2)) & 3], 3);
+                d[3] = 255;
+            }
+        }
+    }
+}
+
+void set_bc1_params(pen::texture_creation_params& tcp, u32 w, u32 h, u8* blocks, u32 data_size)
+{
+    tcp.width = w;
+    tcp.height = h;
+    tcp.format = PEN_TEX_FORMAT_BC1_UNORM;
+    tcp.block_size = 8;
+    tcp.pixels_per_block = 4;
+    tcp.data = blocks;
+    tcp.data_size = data_size;
+}
+
+bool load_compressed_artwork(const Str& filepath, u32 target_width, ByteCache& cache, pen::texture_creation_params& tcp, ArtworkSize& size)
+{
+    Str path = filepath;
+    path.append(".bc1");
+    
+    SharedBytes* bytes = read_cached(cache, path);
+    if(!bytes) {
+        return false;
+    }
+    
+    // blocks are only reused if they were encoded for the same display width
+    CompressedHeader header;
+    bool valid = bytes->size >= sizeof(header);
+    if(valid)
+    {
+        memcpy(&header, bytes->data, sizeof(header));
+        valid = header.magic == k_bc1_magic && header.target_width == target_width && bytes->size >= sizeof(header) + header.data_size;
+    }
+    
+    if(valid)
+    {
+        u8* blocks = (u8*)pen::memory_alloc(header.data_size);
+        memcpy(blocks, bytes->data + sizeof(header), header.data_size);
+        
+        tcp = artwork_params(header.width, header.height, nullptr);
+        set_bc1_params(tcp, header.width, header.height, blocks, header.data_size);
+        size.width = header.source_width;
+        size.height = header.source_height;
+    }
+    
+    release_bytes(bytes);
+    return valid;
+}
+
+void save_compressed_artwork(const Str& filepath, u32 target_width, ByteCache& cache, const pen::texture_creation_params& tcp, const ArtworkSize& size)
+{
+    Str path = filepath;
+    path.append(".bc1");
+    
+    // the file image is built here, the blocks in tcp are handed to the gpu before a background write would finish
+    CompressedHeader header = { k_bc1_magic, tcp.width, tcp.height, size.width, size.height, target_width, tcp.data_size };
+    SharedBytes* bytes = new SharedBytes;
+    bytes->filepath = path;
+    bytes->size = sizeof(header) + tcp.data_size;
+    bytes->data = (u8*)malloc(bytes->size);
+    memcpy(bytes->data, &header, sizeof(header));
+    memcpy(bytes->data + sizeof(header), tcp.data, tcp.data_size);
+    
+    // readers of the old blocks are kept out of the cache, the new ones are served from ram until written
+    byte_cache_erase(cache, path);
+    byte_cache_insert(cache, bytes);
+    pool_submit(s_thread_pool, TaskPriority::maintenance, write_downloaded, bytes, 0);
+}
+
+pen::texture_creation_params load_artwork(const Str& filepath, u32 target_width, ByteCache& cache, ArtworkSize& size, ArtworkSignature* signature, const SharedBytes* downloaded = nullptr)
+{
+    pen::texture_creation_params tcp;
+    if(!downloaded && k_compress_artwork && load_compressed_artwork(filepath, target_width, cache, tcp, size)) {
+        return tcp;
+    }
+    
+    // freshly downloaded artwork may not have reached the disk yet, revisits come from the ram cache
+    SharedBytes* cached = nullptr;
+    if(!downloaded) {
+        cached = read_cached(cache, filepath);
+        downloaded = cached;
+    }
+    
+    tcp = downloaded ? load_texture_from_memory(downloaded->data, downloaded->size, target_width) : artwork_params(0, 0, nullptr);
+    release_bytes(cached);
+    
+    if(!tcp.data) {
+        return tcp;
+    }
+    
+    size.width = tcp.width;
+    size.height = tcp.height;
+    
+    // signature is taken from the rgba before it is compressed
+    if(signature && !signature_valid(*signature)) {
+        *signature = compute_signature(tcp);
+    }
+    
+    if(k_compress_artwork)
+    {
+        u32 data_size = 0;
+        u8* blocks = encode_bc1((const u8*)tcp.data, tcp.width, tcp.height, data_size);
+        pen::memory_free(tcp.data);
+        
+        // dimensions rounded up to whole blocks
+        set_bc1_params(tcp, (tcp.width + 3) & ~3u, (tcp.height + 3) & ~3u, blocks, data_size);
+        save_compressed_artwork(filepath, target_width, cache, tcp, size);
+    }
+    
+    return tcp;
+}
+
+// headless bc1 encode speed and quality over the artwork in the disk cache
+void compression_benchmark(u32 target_width)
+{
+    Str cache_dir = get_cache_path();
+    
+    pen::fs_tree_node dir;
+    pen::filesystem_enum_directory(cache_dir.c_str(), dir);
+    
+    u32 images = 0;
+    f64 encode_ms = 0.0;
+    f64 total_psnr = 0.0;
+    for(u32 d = 0; d < dir.num_children; ++d)
+    {
+        Str release_path = cache_dir;
+        release_path.append(dir.children[d].name);
+        
+        pen::fs_tree_node release_dir;
+        pen::filesystem_enum_directory(release_path.c_str(), release_dir);
+        for(u32 f = 0; f < release_dir.num_children; ++f)
+        {
+            std::string name = release_dir.children[f].name;
+            if(name.find(".jpg") == std::string::npos && name.find(".png") == std::string::npos) {
+                continue;
+            }
+            
+            Str path = release_path;
+            path.appendf("/%s", name.c_str());
+            
+            pen::texture_creation_params tcp = load_texture_from_disk(path, target_width);
+            if(!tcp.data) {
+                continue;
+            }
+            
+            f64 start = pen::get_time_us();
+            u32 data_size = 0;
+            u8* blocks = encode_bc1((const u8*)tcp.data, tcp.width, tcp.height, data_size);
+            encode_ms += (pen::get_time_us() - start) / 1000.0;
+            
+            // psnr of the rgb channels against the source
+            u8* decoded = (u8*)pen::memory_alloc(tcp.data_size);
+            decode_bc1(blocks, tcp.width, tcp.height, decoded);
+            
+            const u8* src = (const u8*)tcp.data;
+            f64 mse = 0.0;
+            u32 samples = tcp.width * tcp.height * 3;
+            for(u32 p = 0; p < tcp.width * tcp.height; ++p)
+            {
+                for(u32 c = 0; c < 3; ++c)
+                {
+                    f64 e = (f64)src[p * 4 + c] - (f64)decoded[p * 4 + c];
+                    mse += e * e;
+                }
+            }
+            mse /= std::max<u32>(samples, 1);
+            total_psnr += mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0;
+            images++;
+            
+            pen::memory_free(decoded);
+            pen::memory_free(blocks);
+            pen::memory_free(tcp.data);
+        }
+        pen::filesystem_enum_free_mem(release_dir);
+    }
+    pen::filesystem_enum_free_mem(dir);
+    
+    if(images > 0) {
+        PEN_LOG("compression benchmark: %u images, %f ms per image, %f db psnr", images, encode_ms / images, total_psnr / images);
+    }
+}
+
+void enumerate_cache(void* userdata, u32)
+{
+    DataContext* data_ctx = (DataContext*)userdata;
+    
+    load_signature_index(data_ctx->signatures);
+    
+    Str cache_dir = get_cache_path();
+    
+    // enum cache stats
+    pen::fs_tree_node dir;
+    pen::filesystem_enum_directory(cache_dir.c_str(), dir, 1, "**/*.*");
+    data_ctx->cached_release_folders = 0;
+    data_ctx->cached_release_bytes = 0;
+    for(u32 i = 0; i < dir.num_children; ++i)
+    {
+        Str path = cache_dir;
+        path.append(dir.children[i].name);
+        
+        if(dir.children[i].num_children > 0)
+        {
+            data_ctx->cached_release_folders++;
+            data_ctx->cached_release_bytes += get_folder_size_recursive(dir.children[i], cache_dir.c_str());
+        }
+        else
+        {
+            pen::fs_tree_node release_dir;
+            pen::filesystem_enum_directory(path.c_str(), release_dir);
+            data_ctx->cached_release_folders++;
+            data_ctx->cached_release_bytes += get_folder_size_recursive(release_dir, path.c_str());
+        }
+    }
+}
+
+void decode_worker(void* userdata, u32);
+
+void queue_decodes(ReleasesView* view, const u32* indices, size_t count)
+{
+    // leave a worker free for downloads
+    u32 max_workers = std::max<u32>(1, s_thread_pool.num_workers - 1);
+    
+    u32 spawn = 0;
+    {
+        std::lock_guard<std::mutex> lock(view->decode_mutex);
+        view->decode_pending.insert(view->decode_pending.end(), indices, indices + count);
+        while(view->decode_workers < max_workers && view->decode_workers < view->decode_pending.size())
+        {
+            view->decode_workers++;
+            spawn++;
+        }
+    }
+    
+    for(u32 w = 0; w < spawn; ++w) {
+        pool_submit(s_thread_pool, TaskPriority::decode, decode_worker, view, 0, &view->pending_tasks);
+    }
+}
+
+void cache_release(void* userdata, u32 i)
+{
+    // get view from userdata
+    ReleasesView* view = (ReleasesView*)userdata;
+    
+    if(view->terminate) {
+        return;
+    }
+    
+    // request may have been cancelled since it was queued
+    if(!(view->releases.requests[i] & RequestFlags::cache)) {
+        return;
+    }
+    
+    // cache art
+    if(state_transition(view->releases.artwork_state[i], EntryState::requested, EntryState::downloading))
+    {
+        SharedBytes* downloaded = nullptr;
+        view->releases.artwork_filepath[i] = download_and_cache(view->releases.artwork_url[i], view->releases.id[i], &downloaded);
+        
+        byte_cache_insert(view->data_ctx->byte_cache, downloaded);
+        
+        // only kept for the decoder if the row still wants its artwork
+        if(downloaded && !(view->releases.requests[i] & RequestFlags::artwork)) {
+            release_bytes(downloaded);
+        }
+        else {
+            stash_downloaded(view->releases, i, downloaded);
+            
+            // the request may have been dropped while stashing, after release_artwork looked
+            if(!(view->releases.requests[i] & RequestFlags::artwork)) {
+                release_bytes(take_downloaded(view->releases, i));
+            }
+        }
+        
+        state_transition(view->releases.artwork_state[i], EntryState::downloading, EntryState::cached);
+        push_state_change(view, i, EntryState::cached);
+        
+        // artwork was requested while downloading, hand over to the decoders
+        if(view->releases.requests[i] & RequestFlags::artwork)
+        {
+            queue_decodes(view, &i, 1);
+        }
+    }
+    
+    // cache tracks
+    if(view->releases.track_url_count[i] > 0)
+    {
+        if(state_transition(view->releases.track_state[i], EntryState::none, EntryState::downloading))
+        {
+            view->releases.track_filepaths[i] = arena_new<Str>(view->arena, view->releases.track_url_count[i]);
+            
+            for(u32 t = 0; t < view->releases.track_url_count[i]; ++t)
+            {
+                view->releases.track_filepaths[i][t] = "";
+                Str fp = download_and_cache(view->releases.track_urls[i][t], view->releases.id[i]);
+                view->releases.track_filepaths[i][t] = fp;
+            }
+            
+            view->releases.track_filepath_count[i] = view->releases.track_url_count[i];
+            state_transition(view->releases.track_state[i], EntryState::downloading, EntryState::cached);
+            push_state_change(view, i, EntryState::cached);
+        }
+    }
+}
+
+void decode_artwork(void* userdata, u32 i)
+{
+    // get view from userdata
+    ReleasesView* view = (ReleasesView*)userdata;
+    
+    // load art if requested and cached, or cached and previously evicted
+    if(view->terminate || !(view->releases.requests[i] & RequestFlags::artwork)) {
+        return;
+    }
+    
+    auto& state = view->releases.artwork_state[i];
+    if(state_transition(state, EntryState::cached, EntryState::decoding) ||
+       state_transition(state, EntryState::evicted, EntryState::decoding))
+    {
+        u32 decode_start = pen::get_time_ms();
+        ArtworkSignature sig = view->releases.artwork_signature[i];
+        bool had_signature = signature_valid(sig);
+        SharedBytes* downloaded = take_downloaded(view->releases, i);
+        view->releases.artwork_tcp[i] = load_artwork(view->releases.artwork_filepath[i], view->data_ctx->artwork_width, view->data_ctx->byte_cache, view->releases.artwork_size[i], &sig, downloaded);
+        release_bytes(downloaded);
+        update_average(s_decode_ms, pen::get_time_ms() - decode_start);
+        if(view->releases.artwork_tcp[i].data) {
+            view->releases.staging_bytes += view->releases.artwork_tcp[i].data_size;
+            s_view_allocations++;
+            
+            // first decode of this artwork, remember its signature for placeholders
+            if(!had_signature && signature_valid(sig))
+            {
+                view->releases.artwork_signature[i] = sig;
+                
+                {
+                    auto& index = view->data_ctx->signatures;
+                    std::lock_guard<std::mutex> lock(index.mutex);
+                    index.signatures[view->releases.id[i].c_str()] = sig;
+                    index.dirty = true;
+                }
+                
+                // links to a matching release from another store the next time a view is built
+                register_artwork_signature(view->data_ctx->dedupe, view->releases.id[i].c_str(), sig);
+            }
+        }
+        
+        // a failed decode goes back to evicted so it can be decoded again, the ui decides when
+        if(!view->releases.artwork_tcp[i].data)
+        {
+            state_transition(state, EntryState::decoding, EntryState::evicted);
+            push_state_change(view, i, EntryState::evicted);
+            return;
+        }
+        
+        state_transition(state, EntryState::decoding, EntryState::decoded);
+        push_state_change(view, i, EntryState::decoded);
+    }
+}
+
+void decode_worker(void* userdata, u32)
+{
+    ReleasesView* view = (ReleasesView*)userdata;
+    
+    for(;;)
+    {
+        // distance is taken when the decode starts, so requests that scrolled away sort last
+        u32 i = 0;
+        {
+            std::lock_guard<std::mutex> lock(view->decode_mutex);
+            auto& pending = view->decode_pending;
+            if(pending.empty() || view->terminate)
+            {
+                view->decode_workers--;
+                return;
+            }
+            
+            u32 top = view->decode_top;
+            size_t nearest = 0;
+            u32 nearest_dist = (u32)-1;
+            for(size_t p = 0; p < pending.size(); ++p)
+            {
+                u32 pos = view->releases.request_pos[pending[p]];
+                u32 dist = pos > top ? pos - top : top - pos;
+                if(dist < nearest_dist)
+                {
+                    nearest = p;
+                    nearest_dist = dist;
+                }
+            }
+            
+            i = pending[nearest];
+            pending[nearest] = pending.back();
+            pending.pop_back();
+        }
+        
+        // entries which left the window since they were queued are dropped here
+        decode_artwork(view, i);
+    }
+}
+
+struct DecodeBenchmarkParams
+{
+    const std::vector<Str>* files;
+    u32                     target_width;
+    std::atomic<u32>*       next;
+    std::atomic<u32>*       running;
+};
+
+void* decode_benchmark_thread(void* userdata)
+{
+    DecodeBenchmarkParams* params = (DecodeBenchmarkParams*)userdata;
+    
+    auto& files = *params->files;
+    for(u32 f = (*params->next)++; f < (u32)files.size(); f = (*params->next)++)
+    {
+        pen::texture_creation_params tcp = load_texture_from_disk(files[f], params->target_width);
+        pen::memory_free(tcp.data);
+    }
+    
+    (*params->running)--;
+    return nullptr;
+}
+
+// headless decode throughput over the artwork in the disk cache, for 1 to max_threads decoding threads
+void decode_benchmark(u32 max_threads, u32 target_width)
+{
+    Str cache_dir = get_cache_path();
+    
+    std::vector<Str> files;
+    pen::fs_tree_node dir;
+    pen::filesystem_enum_directory(cache_dir.c_str(), dir);
+    for(u32 d = 0; d < dir.num_children; ++d)
+    {
+        Str release_path = cache_dir;
+        release_path.append(dir.children[d].name);
+        
+        pen::fs_tree_node release_dir;
+        pen::filesystem_enum_directory(release_path.c_str(), release_dir);
+        for(u32 f = 0; f < release_dir.num_children; ++f)
+        {
+            std::string name = release_dir.children[f].name;
+            if(name.find(".jpg") != std::string::npos || name.find(".jpeg") != std::string::npos || name.find(".png") != std::string::npos)
+            {
+                Str path = release_path;
+                path.appendf("/%s", name.c_str());
+                files.push_back(path);
+            }
+        }
+        pen::filesystem_enum_free_mem(release_dir);
+    }
+    pen::filesystem_enum_free_mem(dir);
+    
+    if(files.empty()) {
+        PEN_LOG("decode benchmark: no cached artwork");
+        return;
+    }
+    
+    for(u32 num_threads = 1; num_threads <= max_threads; ++num_threads)
+    {
+        std::atomic<u32> next = { 0 };
+        std::atomic<u32> running = { num_threads };
+        DecodeBenchmarkParams params = { &files, target_width, &next, &running };
+        
+        // dedicated pen threads, pool workers can't be limited to a thread count and are busy with the feed
+        f64 start = pen::get_time_ms();
+        for(u32 t = 0; t < num_threads; ++t) {
+            pen::thread_create(decode_benchmark_thread, 10 * 1024 * 1024, &params, pen::e_thread_start_flags::detached);
+        }
+        while(running > 0) {
+            pen::thread_sleep_ms(1);
+        }
+        f64 ms = std::max<f64>(pen::get_time_ms() - start, 1.0);
+        
+        PEN_LOG("decode benchmark: %u threads, %u images, %f ms, %f images/s", num_threads, (u32)files.size(), ms, files.size() * 1000.0 / ms);
+    }
+}
+
+// benchmarks run one at a time on a maintenance worker, started from the diagnostics menu
+static std::atomic<u32> s_benchmark_running = { 0 };
+
+void run_compression_benchmark(void* userdata, u32)
+{
+    DataContext* data_ctx = (DataContext*)userdata;
+    compression_benchmark(data_ctx->artwork_width);
+    s_benchmark_running = 0;
+}
+
+void run_decode_benchmark(void* userdata, u32)
+{
+    DataContext* data_ctx = (DataContext*)userdata;
+    decode_benchmark(s_thread_pool.num_workers, data_ctx->artwork_width);
+    s_benchmark_running = 0;
+}
+
+vec2f touch_screen_mouse_wheel()
+{
+    const pen::mouse_state& ms = pen::input_get_mouse_state();
+    vec2f cur = vec2f((f32)ms.x, (f32)ms.y);
+    static vec2f prev = cur;
+    
+    static bool prevdown = false;
+    if(!prevdown) {
+        prev = cur;
     }
     
-    for(;;)
+    vec2f delta = (cur - prev);
+    prev = cur;
+    
+    if(ms.buttons[PEN_MOUSE_L])
     {
-        // grab the latest
-        ctx->latest_registry_status = DataStatus::e_loading;
-        download_and_cache_named("https://raw.githubusercontent.com/polymonster/dig/main/registry/releases.json", "registry.json");
+        prevdown = true;
+        return delta;
+    }
+    
+    prevdown = false;
+    return 0.0f;
+}
+
+namespace
+{
+    pen::job*   s_thread_info = nullptr;
+    pen::timer* frame_timer;
+    u32         clear_screen;
+    AppContext  ctx;
+
+    ReleasesView* new_view(View_t new_view, const FilterState& new_filter, u32 reg_timeout)
+    {
+        ReleasesView* view = new ReleasesView;
+        view->data_ctx = &ctx.data_ctx;
+        view->filter = new_filter;
+        view->view = new_view;
+        view->reg_timeout = reg_timeout;
+        view->scroll = vec2f(0.0f, ctx.w);
         
-        nlohmann::json reg = nlohmann::json::parse(std::ifstream(reg_path.c_str()));
-        ctx->latest_registry_status = DataStatus::e_ready;
+        // view work runs on the shared pool, pending tasks are counted so cleanup knows when it's safe
+        pool_submit(s_thread_pool, TaskPriority::fetch, info_loader, view, 0, &view->pending_tasks);
         
-        ctx->registry_mutex.lock();
-        ctx->registry = reg;
-        ctx->cache_registry_status = DataStatus::e_ready;
-        ctx->registry_mutex.unlock();
+        return view;
+    }
 
-        while(ctx->latest_registry_status == DataStatus::e_ready)
+    bool is_cacheable(ReleasesView* view)
+    {
+        // likes change under the view and settings has no content, only feeds are reused
+        return view->view < View::likes && !view->destroy;
+    }
+    
+    void window_leave(ReleasesView* view, u32 begin, u32 end, RequestFlags_t request);
+    
+    void retire_view(ReleasesView* view)
+    {
+        // unpin the artwork window, textures stay resident for reuse but the pool may now take them
+        u32 end = std::min<u32>(view->artwork_window.end, (u32)view->filtered.size());
+        window_leave(view, std::min(view->artwork_window.begin, end), end, RequestFlags::artwork);
+        
+        // an empty window makes the next update re-enter and pin every position again
+        view->artwork_window = {};
+        
+        view->last_used = pen::get_time_ms();
+        ctx.background_views.insert(view);
+    }
+    
+    ReleasesView* find_cached_view(View_t view)
+    {
+        u32 version = ctx.data_ctx.registry_version;
+        for(auto& cached : ctx.background_views)
         {
-            // wait for a request
-            pen::thread_sleep_ms(66);
+            if(cached->view == view && cached->registry_version == version && is_cacheable(cached))
+            {
+                return cached;
+            }
         }
         
-        PEN_LOG("fetch new reg");
+        return nullptr;
     }
-};
 
-void* user_data_thread(void* userdata)
-{
-    // get user data dir
-    Str user_data_dir = os_get_persistent_data_directory();
-    user_data_dir.append("/dig/user_data/");
+    f32 row_offset(const std::vector<f32>& tree, size_t count);
     
-    // create dir
-    pen::os_create_directory(user_data_dir);
-    
-    // grab likes
-    u32 mtime  = 0;
-    Str likes_filepath = user_data_dir;
-    likes_filepath.appendf("likes.json");
-    pen::filesystem_getmtime(likes_filepath.c_str(), mtime);
-    if(mtime)
+    void change_view(View_t view, const FilterState& filter, u32 reg_timeout = 1000)
     {
-        std::ifstream f(likes_filepath.c_str());
-        s_likes = nlohmann::json::parse(f);;
+        // prevent entering same view twice, filter changes are applied in place
+        if(ctx.view) {
+            if(ctx.view->view == view) {
+                ctx.view->filter = filter;
+                return;
+            }
+        }
+        
+        // top indexes the old view's releases, the new feed finds its own
+        ctx.top = -1;
+        ctx.label_request = k_no_label;
+        
+        // the current feed becomes the back view, everything left is kept in the view cache
+        if(ctx.view)
+        {
+            // row heights are lost if the view is compacted, so remember the position by row
+            ReleasesView* old = ctx.view;
+            if(old->top_pos < old->row_count)
+            {
+                old->anchor_pos = (s32)old->top_pos;
+                old->anchor_offset = old->scroll.y - row_offset(old->row_tree, old->top_pos);
+            }
+            
+            if(ctx.view->view < View::likes)
+            {
+                ctx.back_view = ctx.view;
+            }
+            retire_view(ctx.view);
+        }
+        
+        // reuse a recent feed with its scroll and artwork intact, or kick off a new view
+        ReleasesView* cached = find_cached_view(view);
+        if(cached && cached->tier < ViewTier::compacting)
+        {
+            ctx.background_views.erase(cached);
+            cached->filter = filter;
+            cached->tier = ViewTier::full;
+            ctx.view = cached;
+        }
+        else
+        {
+            ctx.view = new_view(view, filter, reg_timeout);
+            
+            // compact views are rebuilt from the registry in the same order, so the anchor row still applies
+            if(cached)
+            {
+                ctx.view->scroll = cached->scroll;
+                ctx.view->top_pos = cached->top_pos;
+                ctx.view->anchor_pos = cached->anchor_pos;
+                ctx.view->anchor_offset = cached->anchor_offset;
+                cached->destroy = true;
+                
+                if(ctx.back_view == cached) {
+                    ctx.back_view = ctx.view;
+                }
+            }
+        }
     }
 
-    for(;;)
+    void terminate_view(ReleasesView* view)
+    {
+        if(!view->terminate)
+        {
+            view->terminate = 1;
+        }
+    }
+
+    // slot ids in the soa are 1 based, 0 means no slot
+    u32 artwork_texture(soa& releases, size_t i, f32* aspect)
+    {
+        u32 slot = releases.artwork_slot[i];
+        if(slot == 0) {
+            return 0;
+        }
+        
+        // dimensions come from the slot, the decoder may be rewriting artwork_tcp for a level of detail upgrade
+        auto& artwork = ctx.artwork_pool.slots[slot - 1];
+        if(artwork.width == 0 || artwork.height == 0) {
+            return 0;
+        }
+        
+        artwork.last_used = pen::get_time_ms();
+        *aspect = (f32)artwork.height / (f32)artwork.width;
+        return artwork.texture;
+    }
+    
+    void free_artwork_slot(ArtworkPool& pool, u32 slot)
+    {
+        // the texture is kept so the slot can be refilled, evicting the owner leaves its artwork on disk
+        auto& artwork = pool.slots[slot - 1];
+        soa& owner = *artwork.owner;
+        state_transition(owner.artwork_state[artwork.index], EntryState::uploaded, EntryState::evicted);
+        owner.artwork_slot[artwork.index] = 0;
+        owner.texture_bytes -= artwork.bytes;
+        artwork.owner = nullptr;
+    }
+    
+    u32 acquire_artwork_slot(ArtworkPool& pool)
     {
-        if(s_likes_invalidated)
+        if(!pool.free_slots.empty())
         {
-            auto likes = get_likes();
-            auto likes_str = likes.dump();
+            u32 slot = pool.free_slots.back();
+            pool.free_slots.pop_back();
+            return slot;
+        }
+        
+        if(pool.slots.size() < pool.capacity)
+        {
+            pool.slots.push_back(ArtworkSlot());
+            return (u32)pool.slots.size();
+        }
+        
+        // reuse the least recently drawn slot which no row currently has requested
+        u32 lru = 0;
+        for(u32 s = 0; s < (u32)pool.slots.size(); ++s)
+        {
+            auto& artwork = pool.slots[s];
+            if(artwork.owner->requests[artwork.index] & RequestFlags::artwork) {
+                continue;
+            }
             
-            FILE* fp = fopen(likes_filepath.c_str(), "w");
-            fwrite(likes_str.c_str(), likes_str.length(), 1, fp);
-            fclose(fp);
+            if(lru == 0 || artwork.last_used < pool.slots[lru - 1].last_used) {
+                lru = s + 1;
+            }
+        }
+        
+        if(lru != 0) {
+            free_artwork_slot(pool, lru);
         }
         
-        pen::thread_sleep_ms(66);
+        return lru;
     }
-}
-
-void* info_loader(void* userdata)
-{
-    // get view from userdata
-    ReleasesView* view = (ReleasesView*)userdata;
     
-    // wait for a few seconds for a new registry
-    u32 timestart = pen::get_time_ms();
-    bool use_latest = true;
+    bool fill_artwork_slot(ArtworkPool& pool, soa& releases, u32 i)
+    {
+        // a level of detail upgrade refills the slot already showing the lower one
+        u32 slot = releases.artwork_slot[i];
+        if(slot != 0) {
+            releases.texture_bytes -= pool.slots[slot - 1].bytes;
+        }
+        else {
+            slot = acquire_artwork_slot(pool);
+        }
+        
+        if(slot == 0) {
+            return false;
+        }
+        
+        // pen has no sub region texture update, so a refilled slot recreates its texture
+        auto& artwork = pool.slots[slot - 1];
+        if(artwork.texture != 0) {
+            pool.release_texture(artwork.texture);
+        }
+        
+        artwork.texture = pool.create_texture(releases.artwork_tcp[i]);
+        artwork.owner = &releases;
+        artwork.index = i;
+        artwork.last_used = pen::get_time_ms();
+        artwork.bytes = releases.artwork_tcp[i].data_size;
+        artwork.width = releases.artwork_size[i].width;
+        artwork.height = releases.artwork_size[i].height;
+        
+        releases.artwork_slot[i] = slot;
+        releases.texture_bytes += artwork.bytes;
+        return true;
+    }
+
+    void release_artwork(soa& releases, size_t i)
+    {
+        // unpins the slot, the texture stays resident until the pool needs it again
+        releases.requests[i] &= ~RequestFlags::artwork;
+        
+        // downloaded bytes waiting for a decode which will not happen now
+        release_bytes(take_downloaded(releases, i));
+    }
     
-    if(view->reg_timeout > 1000)
+    void evict_artwork(soa& releases, size_t i)
     {
-        view->data_ctx->latest_registry_status = DataStatus::e_loading;
+        release_artwork(releases, i);
+        
+        u32 slot = releases.artwork_slot[i];
+        if(slot != 0)
+        {
+            free_artwork_slot(ctx.artwork_pool, slot);
+            ctx.artwork_pool.free_slots.push_back(slot);
+        }
     }
     
-    // grab registry; either latest or cached
-    nlohmann::json releases_registry;
+    struct column_bytes_func
+    {
+        size_t bytes = 0;
+        
+        template<typename T>
+        void operator()(soa_column<T>& col)
+        {
+            bytes += col.capacity * sizeof(T);
+        }
+    };
     
-    while(view->data_ctx->cache_registry_status != DataStatus::e_ready)
+    size_t view_metadata_memory(ReleasesView* view)
     {
-        // need to wait on cached
-        pen::thread_sleep_ms(16);
+        // strings, track lists and cold columns
+        if(view->tier >= ViewTier::compacting) {
+            return 0;
+        }
+        
+        column_bytes_func cold;
+        view->releases.visit_cold(cold);
+        
+        std::lock_guard<std::mutex> lock(view->arena.mutex);
+        return view->arena.bytes + cold.bytes;
     }
     
-    view->data_ctx->registry_mutex.lock();
-    releases_registry = view->data_ctx->registry;
-    view->data_ctx->registry_mutex.unlock();
+    size_t view_memory(ReleasesView* view)
+    {
+        if(view->tier >= ViewTier::compacting) {
+            return 0;
+        }
+        
+        return view->releases.texture_bytes + view->releases.staging_bytes + view_metadata_memory(view);
+    }
     
-    // grab items for this requested view from the registry
-    std::vector<ChartItem> view_chart;
-    std::string view_name = View::lookup_names[view->view];
+    void free_view_memory(ReleasesView* view)
+    {
+        // workers have finished so states are stable
+        auto& releases = view->releases;
+        for(size_t i = 0; i < releases.available_entries; ++i) {
+            evict_artwork(releases, i);
+            
+            // pixels decoded but not yet uploaded
+            free_staging(releases, i);
+        }
+        
+        // strings, track lists and store links are all owned by the arena
+        arena_release(view->arena);
+        
+        // leak check, everything the view staged, uploaded or allocated must have been returned
+        if(releases.staging_bytes != 0 || releases.texture_bytes != 0 || view->arena.bytes != 0)
+        {
+            PEN_LOG("view leaked: staging %zu, textures %zu, arena %zu", (size_t)releases.staging_bytes, (size_t)releases.texture_bytes, (size_t)view->arena.bytes);
+            PEN_ASSERT(0);
+        }
+        
+        // cleanup memory from the soa itself
+        free_components(view->releases);
+    }
     
-    if(view->view == View::likes)
+    size_t downgrade_view(ReleasesView* view)
     {
-        for(auto& like : s_likes.items())
+        // steps a background view down one tier, returns the estimated bytes given up
+        auto& releases = view->releases;
+        size_t bytes = 0;
+        
+        if(view->tier == ViewTier::full)
         {
-            if(releases_registry.contains(like.key()) && like.value())
-            {
-                view_chart.push_back({
-                    like.key(),
-                    0
-                });
+            // textures come back from the disk cache via the request windows if the view is reused
+            bytes = releases.texture_bytes;
+            for(size_t i = 0; i < releases.available_entries; ++i) {
+                evict_artwork(releases, i);
+            }
+            view->artwork_window = {};
+            view->tier = ViewTier::no_textures;
+        }
+        else if(view->tier == ViewTier::no_textures)
+        {
+            // pixels waiting for an upload which is no longer wanted
+            bytes = releases.staging_bytes;
+            for(size_t i = 0; i < releases.available_entries; ++i) {
+                if(state_transition(releases.artwork_state[i], EntryState::decoded, EntryState::evicted)) {
+                    free_staging(releases, i);
+                }
             }
+            view->tier = ViewTier::no_pixels;
+        }
+        else if(view->tier == ViewTier::no_pixels)
+        {
+            // strings and columns are freed once in flight tasks have drained
+            bytes = view_memory(view);
+            terminate_view(view);
+            view->tier = ViewTier::compacting;
+        }
+        
+        return bytes;
+    }
+
+    void free_pool_slot(ArtworkPool& pool, u32 slot)
+    {
+        // gives the gpu memory back rather than keeping the texture for a refill
+        auto& artwork = pool.slots[slot - 1];
+        if(artwork.owner) {
+            free_artwork_slot(pool, slot);
+        }
+        
+        if(artwork.texture != 0)
+        {
+            pool.release_texture(artwork.texture);
+            artwork.texture = 0;
+            artwork.bytes = 0;
+            pool.free_slots.push_back(slot);
         }
     }
-    else
+    
+    size_t parked_texture_bytes(ArtworkPool& pool)
     {
-        // populate view
-        for(auto& item : releases_registry)
+        // evicted artwork leaves its texture in a free slot for the next fill, no view counts it
+        size_t bytes = 0;
+        for(auto& slot : pool.free_slots) {
+            bytes += pool.slots[slot - 1].bytes;
+        }
+        return bytes;
+    }
+    
+    size_t release_parked_textures(ArtworkPool& pool)
+    {
+        size_t freed = 0;
+        for(auto& slot : pool.free_slots)
         {
-            if(item.contains(view_name))
+            auto& artwork = pool.slots[slot - 1];
+            if(artwork.texture != 0)
             {
-                view_chart.push_back({
-                    item["id"],
-                    item[view_name]
-                });
+                pool.release_texture(artwork.texture);
+                freed += artwork.bytes;
+                artwork.texture = 0;
+                artwork.bytes = 0;
             }
         }
+        return freed;
     }
     
-    // sort the items
-    std::sort(begin(view_chart),end(view_chart),[](ChartItem a, ChartItem b) {return a.pos < b.pos; });
-    
-    // make space
-    resize_components(view->releases, view_chart.size());
-    
-    for(auto& entry : view_chart)
+    size_t trim_artwork_pool(ArtworkPool& pool, size_t bytes, bool pressure)
     {
-        u32 ri = (u32)view->releases.available_entries;
-        auto release = releases_registry[entry.index];
+        // unpinned slots furthest from the viewport go first, background views before the current one, then oldest
+        static std::vector<std::pair<u64, u32>> s_candidates;
+        s_candidates.clear();
         
-        // grab tags
-        /*
-        if(release.contains("tags"))
+        u32 top = ctx.view ? ctx.view->top_pos : 0;
+        for(u32 s = 0; s < (u32)pool.slots.size(); ++s)
         {
-            u32 tags = get_tags(release["tags"]);
-            if(!(tags & view->tags))
-            {
+            auto& artwork = pool.slots[s];
+            if(!artwork.owner || (artwork.owner->requests[artwork.index] & RequestFlags::artwork)) {
                 continue;
             }
+            
+            u64 distance = 0xffffffff;
+            if(ctx.view && artwork.owner == &ctx.view->releases)
+            {
+                u32 pos = artwork.owner->request_pos[artwork.index];
+                distance = pos > top ? pos - top : top - pos;
+            }
+            
+            u64 age = std::min<u32>(pen::get_time_ms() - artwork.last_used, 0xffffffff);
+            s_candidates.push_back(std::make_pair((distance << 32) | age, s + 1));
         }
-        */
         
-        // simple info
-        view->releases.artist[ri] = release["artist"];
-        view->releases.title[ri] = release["title"];
-        view->releases.link[ri] = release["link"];
-        view->releases.label[ri] = release["label"];
-        view->releases.cat[ri] = release["cat"];
-        
-        // clear
-        view->releases.artwork_filepath[ri] = "";
-        view->releases.artwork_texture[ri] = 0;
-        view->releases.flags[ri] = 0;
-        view->releases.track_name_count[ri] = 0;
-        view->releases.track_names[ri] = nullptr;
-        view->releases.track_url_count[ri] = 0;
-        view->releases.track_urls[ri] = nullptr;
-        view->releases.track_filepath_count[ri] = 0;
-        view->releases.select_track[ri] = 0; // reset
-        memset(&view->releases.artwork_tcp[ri], 0x0, sizeof(pen::texture_creation_params));
+        std::sort(s_candidates.begin(), s_candidates.end(), [](const std::pair<u64, u32>& a, const std::pair<u64, u32>& b) {
+            return a.first > b.first;
+        });
         
-        std::string id = release["id"];
-        view->releases.id[ri] = id.c_str();
-
-        // assign artwork url
-        if(release["artworks"].size() > 1)
+        size_t freed = 0;
+        for(auto& candidate : s_candidates)
         {
-            view->releases.artwork_url[ri] = release["artworks"][1];
+            if(!pressure && freed >= bytes) {
+                break;
+            }
+            
+            freed += pool.slots[candidate.second - 1].bytes;
+            free_pool_slot(pool, candidate.second);
         }
-        else
-        {
-            view->releases.artwork_url[ri] = "";
+        
+        return freed;
+    }
+    
+    void poll_memory_pressure()
+    {
+#ifdef PEN_PLATFORM_IOS
+        // pen forwards no low memory notification, so poll what the os will still give us and respond on the falling edge
+        static bool s_low = false;
+        bool low = os_proc_available_memory() < k_low_memory_bytes;
+        if(low && !s_low) {
+            ctx.memory.pressure = 1;
         }
-
-        // track names
-        u32 name_count = (u32)release["track_names"].size();
-        if(name_count > 0)
+        s_low = low;
+#endif
+    }
+    
+    size_t drop_staging(ReleasesView* view)
+    {
+        // decoded pixels for rows which left the window before upload
+        auto& releases = view->releases;
+        size_t freed = 0;
+        for(auto& i : view->uploads)
         {
-            view->releases.track_names[ri] = new Str[name_count];
-            for(u32 t = 0; t < release["track_names"].size(); ++t)
-            {
-                view->releases.track_names[ri][t] = release["track_names"][t];
+            if(releases.requests[i] & RequestFlags::artwork) {
+                continue;
             }
             
-            std::atomic_thread_fence(std::memory_order_release);
-            view->releases.track_name_count[ri] = name_count;
+            if(state_transition(releases.artwork_state[i], EntryState::decoded, EntryState::evicted))
+            {
+                freed += releases.artwork_tcp[i].data_size;
+                free_staging(releases, i);
+            }
         }
-
-        // track urls
-        u32 url_count = (u32)release["track_urls"].size();
-        if(url_count > 0)
+        return freed;
+    }
+    
+    void manage_memory()
+    {
+        auto& memory = ctx.memory;
+        
+        // account every live view
+        static std::vector<ReleasesView*> s_live;
+        s_live.clear();
+        s_live.push_back(ctx.view);
+        if(ctx.reload_view) {
+            s_live.push_back(ctx.reload_view);
+        }
+        for(auto& view : ctx.background_views) {
+            s_live.push_back(view);
+        }
+        
+        memory.texture_bytes = 0;
+        memory.staging_bytes = 0;
+        memory.metadata_bytes = 0;
+        for(auto& view : s_live)
         {
-            view->releases.track_urls[ri] = new Str[url_count];
-            for(u32 t = 0; t < release["track_urls"].size(); ++t)
-            {
-                view->releases.track_urls[ri][t] = release["track_urls"][t];
+            if(view->tier >= ViewTier::compacting) {
+                continue;
             }
             
-            std::atomic_thread_fence(std::memory_order_release);
-            view->releases.track_url_count[ri] = url_count;
+            memory.texture_bytes += view->releases.texture_bytes;
+            memory.staging_bytes += view->releases.staging_bytes;
+            memory.metadata_bytes += view_metadata_memory(view);
         }
+        memory.texture_bytes += parked_texture_bytes(ctx.artwork_pool);
         
-        // check likes
-        if(has_like(view->releases.id[ri]))
+        // the parsed registry is several times its size on disk
+        memory.registry_bytes = ctx.data_ctx.registry_bytes * 4;
+        auto& byte_cache = ctx.data_ctx.byte_cache;
         {
-            view->releases.flags[ri] |= EntryFlags::liked;
+            std::lock_guard<std::mutex> lock(byte_cache.mutex);
+            memory.cache_bytes = byte_cache.bytes;
+        }
+        
+        memory.resident_bytes = memory.texture_bytes + memory.staging_bytes + memory.metadata_bytes + memory.registry_bytes + memory.cache_bytes;
+        
+        poll_memory_pressure();
+        bool pressure = memory.pressure.exchange(0) != 0;
+        if(!pressure && memory.resident_bytes <= memory.budget) {
+            return;
         }
         
-        // store tags
-        if(release.contains("store_tags"))
+        // under os pressure every background feed is compacted straight away
+        if(pressure)
         {
-            for(u32 t = 0; t < PEN_ARRAY_SIZE(StoreTags::names); ++t) {
-                if(release["store_tags"].contains(StoreTags::names[t]) && release["store_tags"][StoreTags::names[t]])
-                {
-                    view->releases.store_tags[ri] |= (1<<t);
+            memory.pressure_events++;
+            for(auto& view : ctx.background_views)
+            {
+                while(!view->destroy && view->tier < ViewTier::compacting) {
+                    downgrade_view(view);
                 }
             }
         }
-
-        pen::thread_sleep_ms(1);
-        view->releases.available_entries++;
-    }
-    
-    view->threads_terminated++;
-    return nullptr;
-}
-
-size_t get_folder_size_recursive(const pen::fs_tree_node& dir, const c8* root)
-{
-    size_t size = 0;
-    for(u32 i = 0; i < dir.num_children; ++i)
-    {
-        Str path = "";
-        path.appendf("%s/%s", root, dir.children[i].name);
         
-        if(dir.children[i].num_children > 0)
+        // textures nothing is showing go first, including those just parked by compacting views
+        size_t over = memory.resident_bytes > memory.budget ? memory.resident_bytes - memory.budget : 0;
+        size_t freed = release_parked_textures(ctx.artwork_pool);
+        freed += drop_staging(ctx.view);
+        
+        // ram copies of files are the cheapest to get back
         {
-            size += get_folder_size_recursive(dir.children[i], path.c_str());
+            std::lock_guard<std::mutex> lock(byte_cache.mutex);
+            size_t cache_budget = pressure ? 0 : byte_cache.bytes - std::min(byte_cache.bytes, over - std::min(over, freed));
+            freed += byte_cache.bytes;
+            byte_cache_trim(byte_cache, cache_budget);
+            freed -= byte_cache.bytes;
         }
-        else
-        {
-            size += filesystem_getsize(path.c_str());
+        
+        if(pressure || freed < over) {
+            trim_artwork_pool(ctx.artwork_pool, over - std::min(over, freed), pressure);
         }
     }
-    
-    return size;
-}
 
-void* data_cacher(void* userdata)
-{
-    // get view from userdata
-    ReleasesView* view = (ReleasesView*)userdata;
-    
-    Str cache_dir = get_cache_path();
-    
-    // enum cache stats
-    pen::fs_tree_node dir;
-    pen::filesystem_enum_directory(cache_dir.c_str(), dir, 1, "**/*.*");
-    view->data_ctx->cached_release_folders = 0;
-    view->data_ctx->cached_release_bytes = 0;
-    for(u32 i = 0; i < dir.num_children; ++i)
+    void cleanup_views()
     {
-        Str path = cache_dir;
-        path.append(dir.children[i].name);
+        std::vector<ReleasesView*> to_remove;
         
-        if(dir.children[i].num_children > 0)
+        // most recently used first, gathering the memory held by background feeds
+        static std::vector<ReleasesView*> s_cached;
+        s_cached.clear();
+        
+        size_t total_bytes = 0;
+        for(auto& view : ctx.background_views)
         {
-            view->data_ctx->cached_release_folders++;
-            view->data_ctx->cached_release_bytes += get_folder_size_recursive(dir.children[i], cache_dir.c_str());
+            if(view == ctx.view || view == ctx.reload_view || view->destroy) {
+                continue;
+            }
+            
+            if(view != ctx.back_view && (view->view >= View::likes || view->registry_version != ctx.data_ctx.registry_version)) {
+                terminate_view(view);
+                view->destroy = true;
+                continue;
+            }
+            
+            s_cached.push_back(view);
+            total_bytes += view_memory(view);
         }
-        else
+        
+        std::sort(s_cached.begin(), s_cached.end(), [](ReleasesView* a, ReleasesView* b) {
+            return a->last_used > b->last_used;
+        });
+        
+        // bound the number of feeds kept
+        for(size_t c = k_view_cache_size; c < s_cached.size(); ++c)
         {
-            pen::fs_tree_node release_dir;
-            pen::filesystem_enum_directory(path.c_str(), release_dir);
-            view->data_ctx->cached_release_folders++;
-            view->data_ctx->cached_release_bytes += get_folder_size_recursive(release_dir, path.c_str());
+            ReleasesView* view = s_cached[c];
+            if(view != ctx.back_view)
+            {
+                total_bytes -= view_memory(view);
+                terminate_view(view);
+                view->destroy = true;
+            }
         }
-    }
         
-    for(;;)
-    {
-        if(view->terminate) {
-            break;
+        // over budget, step the least recently used feeds down a tier at a time
+        for(size_t c = s_cached.size(); c > 0 && total_bytes > k_background_view_budget; --c)
+        {
+            ReleasesView* view = s_cached[c - 1];
+            while(!view->destroy && view->tier < ViewTier::compacting && total_bytes > k_background_view_budget)
+            {
+                total_bytes -= std::min(total_bytes, downgrade_view(view));
+            }
         }
         
-        // waits on info loader thread
-        for(size_t i = 0; i < view->releases.available_entries; ++i)
+        for(auto& view : ctx.background_views)
         {
-            if(!(view->releases.flags[i] & EntryFlags::cache_url_requested)) {
+            if(view == ctx.view || !view->terminate || view->pending_tasks != 0) {
                 continue;
             }
             
-            // cache art
-            if(!view->releases.artwork_url[i].empty())
-            {
-                if(view->releases.artwork_filepath[i].empty())
-                {
-                    view->releases.artwork_filepath[i] = download_and_cache(view->releases.artwork_url[i], view->releases.id[i]);
-                    view->releases.flags[i] |= EntryFlags::artwork_cached;
-                }
+            if(view->tier != ViewTier::compact) {
+                free_view_memory(view);
+                view->tier = ViewTier::compact;
             }
             
-            // cache tracks
-            if(!(view->releases.flags[i] & EntryFlags::tracks_cached))
-            {
-                if(view->releases.track_url_count[i] > 0 && view->releases.track_filepaths[i] == nullptr)
-                {
-                    view->releases.track_filepaths[i] = new Str[view->releases.track_url_count[i]];
-                    
-                    for(u32 t = 0; t < view->releases.track_url_count[i]; ++t)
-                    {
-                        view->releases.track_filepaths[i][t] = "";
-                        Str fp = download_and_cache(view->releases.track_urls[i][t], view->releases.id[i]);
-                        view->releases.track_filepaths[i][t] = fp;
-                    }
-                    
-                    std::atomic_thread_fence(std::memory_order_release);
-                    view->releases.flags[i] |= EntryFlags::tracks_cached;
-                    view->releases.track_filepath_count[i] = view->releases.track_url_count[i];
-                }
+            if(ctx.audio.view == view) {
+                ctx.audio.view = nullptr;
+            }
+            
+            // add to remove list to preserve the set iterator
+            if(view->destroy && view != ctx.back_view) {
+                to_remove.push_back(view);
             }
         }
         
-        pen::thread_sleep_ms(16);
+        // erase view
+        for(auto& rm : to_remove) {
+            PEN_LOG("erasing view");
+            ctx.background_views.erase(ctx.background_views.find(rm));
+            delete rm;
+        }
     }
-    
-    // flag terminated
-    view->threads_terminated++;
-    return nullptr;
-}
 
-void* data_loader(void* userdata)
-{
-    // get view from userdata
-    ReleasesView* view = (ReleasesView*)userdata;
-    
-    for(;;)
+    void request_cache(soa& releases, u32 i, std::vector<u32>& batch)
     {
-        if(view->terminate) {
-            break;
-        }
-        
-        for(size_t i = 0; i < view->releases.available_entries; ++i)
+        if(!(releases.requests[i] & RequestFlags::cache))
         {
-            // load art if cached and not loaded
-            std::atomic_thread_fence(std::memory_order_acquire);
-            
-            if((view->releases.flags[i] & EntryFlags::artwork_cached) &&
-               !(view->releases.flags[i] & EntryFlags::artwork_loaded) &&
-               (view->releases.flags[i] & EntryFlags::artwork_requested))
+            releases.requests[i] |= RequestFlags::cache;
+            if(!releases.artwork_url[i].empty())
             {
-                view->releases.artwork_tcp[i] = load_texture_from_disk(view->releases.artwork_filepath[i]);
-                
-                std::atomic_thread_fence(std::memory_order_release);
-                view->releases.flags[i] |= EntryFlags::artwork_loaded;
+                state_transition(releases.artwork_state[i], EntryState::none, EntryState::requested);
             }
+            batch.push_back(i);
         }
-        
-        pen::thread_sleep_ms(16);
     }
-    
-    view->threads_terminated++;
-    return nullptr;
-}
 
-vec2f touch_screen_mouse_wheel()
-{
-    const pen::mouse_state& ms = pen::input_get_mouse_state();
-    vec2f cur = vec2f((f32)ms.x, (f32)ms.y);
-    static vec2f prev = cur;
-    
-    static bool prevdown = false;
-    if(!prevdown) {
-        prev = cur;
+    void request_artwork(soa& releases, u32 i, std::vector<u32>& batch)
+    {
+        if(!(releases.requests[i] & RequestFlags::artwork))
+        {
+            releases.requests[i] |= RequestFlags::artwork;
+            batch.push_back(i);
+        }
+    }
+
+    void cancel_cache(soa& releases, size_t i)
+    {
+        if(releases.requests[i] & RequestFlags::cache)
+        {
+            releases.requests[i] &= ~RequestFlags::cache;
+            state_transition(releases.artwork_state[i], EntryState::requested, EntryState::none);
+        }
+    }
+
+    u32 renderer_create_texture(const pen::texture_creation_params& tcp)
+    {
+        return pen::renderer_create_texture(tcp);
     }
     
-    vec2f delta = (cur - prev);
-    prev = cur;
-    
-    if(ms.buttons[PEN_MOUSE_L])
+    void renderer_release_texture(u32 texture)
     {
-        prevdown = true;
-        return delta;
+        pen::renderer_release_texture(texture);
     }
     
-    prevdown = false;
-    return 0.0f;
-}
-
-namespace
-{
-    pen::job*   s_thread_info = nullptr;
-    pen::timer* frame_timer;
-    u32         clear_screen;
-    AppContext  ctx;
-
-    ReleasesView* new_view(View_t new_view, Tags_t new_tags, u32 reg_timeout)
+    void upload_textures(ReleasesView* view, const UploadBudget& budget, ArtworkPool& pool, UploadStats& stats)
     {
-        ReleasesView* view = new ReleasesView;
-        view->data_ctx = &ctx.data_ctx;
-        view->tags = new_tags;
-        view->view = new_view;
-        view->reg_timeout = reg_timeout;
-        view->scroll = vec2f(0.0f, ctx.w);
+        auto& releases = view->releases;
+        auto& uploads = view->uploads;
         
-        // workers per view
-        pen::thread_create(info_loader, 10 * 1024 * 1024, view, pen::e_thread_start_flags::detached);
-        pen::thread_create(data_cacher, 10 * 1024 * 1024, view, pen::e_thread_start_flags::detached);
-        pen::thread_create(data_loader, 10 * 1024 * 1024, view, pen::e_thread_start_flags::detached);
+        // nearest the viewport last so they pop first, filtered is in ascending release order
+        u32 top = view->top_pos;
+        auto distance = [view, top](u32 i) {
+            auto it = std::lower_bound(view->filtered.begin(), view->filtered.end(), i);
+            s32 pos = (s32)(it - view->filtered.begin());
+            return abs(pos - (s32)top);
+        };
         
-        return view;
+        std::sort(uploads.begin(), uploads.end(), [&distance](u32 a, u32 b) {
+            return distance(a) > distance(b);
+        });
+        
+        stats.frame_uploads = 0;
+        stats.frame_bytes = 0;
+        
+        f64 start = pen::get_time_us();
+        f32 elapsed_ms = 0.0f;
+        while(!uploads.empty())
+        {
+            // always make progress, then stop once either budget is spent
+            if(stats.frame_uploads > 0 && (elapsed_ms >= budget.ms || stats.frame_bytes >= budget.bytes)) {
+                break;
+            }
+            
+            u32 i = uploads.back();
+            uploads.pop_back();
+            
+            // evicted or freed since it was queued
+            if(releases.artwork_state[i] != EntryState::decoded || !releases.artwork_tcp[i].data) {
+                continue;
+            }
+            
+            bool requested = releases.requests[i] & RequestFlags::artwork;
+            if(requested && fill_artwork_slot(pool, releases, i))
+            {
+                // upload
+                state_transition(releases.artwork_state[i], EntryState::decoded, EntryState::uploaded);
+                
+                stats.frame_uploads++;
+                stats.frame_bytes += releases.artwork_tcp[i].data_size;
+                stats.total_uploads++;
+            }
+            else if(requested)
+            {
+                // every slot is pinned, stay decoded and try again next frame once rows have unpinned
+                uploads.push_back(i);
+                break;
+            }
+            else
+            {
+                // scrolled out of range before we got to upload
+                state_transition(releases.artwork_state[i], EntryState::decoded, EntryState::evicted);
+            }
+            
+            free_staging(releases, i); // data is copied for the render thread. safe to delete
+            elapsed_ms = (f32)((pen::get_time_us() - start) / 1000.0);
+        }
+        
+        stats.queue_depth = (u32)uploads.size();
+        stats.frame_ms = elapsed_ms;
+        stats.max_frame_ms = std::max(stats.max_frame_ms, elapsed_ms);
     }
 
-    void change_view(View_t view, Tags_t tags, u32 reg_timeout = 1000)
+    void apply_state_changes(ReleasesView* view)
     {
-        // prevent entering same view twice
-        if(ctx.view) {
-            if(ctx.view->view == view && ctx.view->tags == tags) {
-                return;
+        static std::vector<StateChange> s_changes;
+        s_changes.clear();
+        
+        view->state_changes.mutex.lock();
+        std::swap(s_changes, view->state_changes.changes);
+        view->state_changes.mutex.unlock();
+        
+        // decoded artwork is queued and uploaded within the frame budget, failed decodes are retried later
+        u32 now = pen::get_time_ms();
+        for(auto& change : s_changes)
+        {
+            if(change.state == EntryState::decoded)
+            {
+                view->uploads.push_back(change.index);
+                if(!view->decode_failures.empty()) {
+                    view->decode_failures.erase(change.index);
+                }
+            }
+            else if(change.state == EntryState::evicted)
+            {
+                u32& failures = view->decode_failures[change.index];
+                if(++failures <= k_decode_retries) {
+                    view->decode_retries.push_back({change.index, now + k_decode_retry_ms * failures});
+                }
+                else {
+                    PEN_LOG("failed to decode artwork: %s", view->releases.artwork_filepath[change.index].c_str());
+                }
             }
         }
         
-        // first we add the current view into background views
-        if(ctx.view && ctx.view->view < View::likes)
+        static std::vector<u32> s_retry;
+        s_retry.clear();
+        auto& retries = view->decode_retries;
+        for(size_t r = 0; r < retries.size();)
         {
-            ctx.back_view = ctx.view;
-            ctx.background_views.insert(ctx.view);
-        }
+            if((s32)(now - retries[r].due_ms) < 0) {
+                ++r;
+                continue;
+            }
             
-        // kick off a new view
-        ctx.view = new_view(view, tags, reg_timeout);
+            u32 i = retries[r].index;
+            retries[r] = retries.back();
+            retries.pop_back();
+            
+            if((view->releases.requests[i] & RequestFlags::artwork) && view->releases.artwork_state[i] == EntryState::evicted) {
+                s_retry.push_back(i);
+            }
+        }
+        
+        if(!s_retry.empty()) {
+            queue_decodes(view, s_retry.data(), s_retry.size());
+        }
+        
+        upload_textures(view, ctx.upload_budget, ctx.artwork_pool, ctx.upload_stats);
     }
 
-    void cleanup_views()
+    void update_filter(ReleasesView* view)
     {
-        std::vector<ReleasesView*> to_remove;
+        auto& releases = view->releases;
+        size_t available = releases.available_entries;
         
-        for(auto& view : ctx.background_views)
+        // filter changed, rebuild the whole selection and release artwork no longer in the feed
+        if(view->filter != view->filtered_state || view->filter_dirty || view->query.nodes.empty())
         {
-            if(view != ctx.back_view && view != ctx.view)
+            view->query = build_query(view->filter);
+            view->filtered_state = view->filter;
+            view->filter_dirty = false;
+            view->filtered.clear();
+            view->filter_generation++;
+            
+            evaluate_query(view->query, releases, 0, available, view->filtered);
+            
+            for(size_t i = 0; i < available; ++i)
             {
-                view->terminate = 1;
-                if(view->threads_terminated == 3)
+                if(releases.requests[i])
                 {
-                    auto& releases = view->releases;
-                    for(size_t i = 0; i < releases.available_entries; ++i) {
-                        // unload textures
-                        if (releases.flags[i] & EntryFlags::artwork_loaded) {
-                            if(releases.artwork_texture[i] != 0) {
-                                // textures themseleves
-                                pen::renderer_release_texture(releases.artwork_texture[i]);
-                                releases.artwork_texture[i] = 0;
-                            }
-                            else
-                            {
-                                // TODO: free
-                                // texture preloaded from disk
-                                //free(releases.artwork_tcp[i].data);
-                            }
-                            memset(&releases.artwork_tcp, 0x0, sizeof(texture_creation_params));
-                            releases.flags[i] &= ~EntryFlags::artwork_loaded;
-                            releases.flags[i] &= ~EntryFlags::artwork_requested;
-                        }
-                        
-                        // unload strings
-                        if(view->releases.track_filepaths[i]) {
-                            delete[] view->releases.track_filepaths[i];
-                        }
-                        
-                        if(view->releases.track_names.data && view->releases.track_names[i]) {
-                            delete[] view->releases.track_names[i];
-                        }
-                        
-                        if(view->releases.track_urls[i]) {
-                            delete[] view->releases.track_urls[i];
-                        }
+                    if(!std::binary_search(view->filtered.begin(), view->filtered.end(), (u32)i))
+                    {
+                        release_artwork(releases, i);
+                        cancel_cache(releases, i);
                     }
-                    
-                    // cleanup memory from the soa itself
-                    free_components(view->releases);
-                    
-                    // add to remove list to preserve the set iterator
-                    to_remove.push_back(view);
                 }
             }
         }
-        
-        // erase view
-        for(auto& rm : to_remove) {
-            PEN_LOG("erasing view");
-            ctx.background_views.erase(ctx.background_views.find(rm));
+        else
+        {
+            // append new entries
+            evaluate_query(view->query, releases, view->filtered_entries, available, view->filtered);
         }
+        
+        view->filtered_entries = available;
     }
 
     void view_reload()
@@ -929,7 +3505,7 @@ namespace
                     if(ctx.reload_view == nullptr && ctx.view->view != View::likes)
                     {
                         // spawn reload view
-                        ctx.reload_view = new_view(ctx.view->view, ctx.view->tags, 5000);
+                        ctx.reload_view = new_view(ctx.view->view, ctx.view->filter, 5000);
                         debounce = true; // wait for debounce;
                     }
                 }
@@ -957,7 +3533,7 @@ namespace
             if(ctx.reload_view->releases.available_entries > 0)
             {
                 // swap existing view with the new one and reset
-                ctx.background_views.insert(ctx.view);
+                retire_view(ctx.view);
                 ctx.view = ctx.reload_view;
                 ctx.reload_view = nullptr;
             }
@@ -968,7 +3544,6 @@ namespace
     {
         // view info
         View_t cur_view = ctx.view->view;
-        Tags_t cur_tags = ctx.view->tags;
         
         if(cur_view != View::likes)
         {
@@ -996,15 +3571,15 @@ namespace
             {
                 if(ImGui::MenuItem("Latest"))
                 {
-                    change_view(View::latest, ctx.view->tags);
+                    change_view(View::latest, ctx.view->filter);
                 }
                 if(ImGui::MenuItem("Weekly Chart"))
                 {
-                    change_view(View::weekly_chart, ctx.view->tags);
+                    change_view(View::weekly_chart, ctx.view->filter);
                 }
                 if(ImGui::MenuItem("Monthly Chart"))
                 {
-                    change_view(View::monthly_chart, ctx.view->tags);
+                    change_view(View::monthly_chart, ctx.view->filter);
                 }
                 ImGui::EndPopup();
             }
@@ -1015,23 +3590,47 @@ namespace
             ImGui::Dummy(ImVec2(k_indent1, 0.0f));
             ImGui::SameLine();
                     
-            ImGui::Text("%s", get_tags_str(ctx.view->tags).c_str());
+            ImGui::Text("%s", get_tags_str(ctx.data_ctx.genre_tags, ctx.view->filter.tags).c_str());
             ImVec2 tag_menu_pos = ImGui::GetItemRectMin();
             tag_menu_pos.y = ImGui::GetItemRectMax().y;
             
             if(ImGui::IsItemClicked()) {
-                ImGui::OpenPopup("Tag Select");
+                ImGui::OpenPopup("Tag Select");
+            }
+            
+            ImGui::SetNextWindowPos(tag_menu_pos);
+            if(ImGui::BeginPopup("Tag Select"))
+            {
+                // count tags for entries which arrived since the last count
+                size_t available = ctx.view->releases.available_entries;
+                count_tags(ctx.view->releases.genre_tags, ctx.view->tag_counts_entries, available, ctx.view->tag_counts);
+                ctx.view->tag_counts_entries = available;
+                
+                // tags are applied in place, the feed re-filters next frame
+                ImGui::SetWindowFontScale(k_text_size_h2);
+                ctx.view->filter.tags = tag_menu(ctx.data_ctx.genre_tags, ctx.view->filter.tags, ctx.view->tag_counts);
+                ImGui::EndPopup();
+                ImGui::SetWindowFontScale(k_text_size_body);
+            }
+            
+            // filters
+            ImGui::Dummy(ImVec2(k_indent1, 0.0f));
+            ImGui::SameLine();
+            
+            ImGui::Text("%s %s", ICON_FA_FILTER, get_filter_str(ctx.data_ctx, ctx.view->filter).c_str());
+            ImVec2 filter_menu_pos = ImGui::GetItemRectMin();
+            filter_menu_pos.y = ImGui::GetItemRectMax().y;
+            
+            if(ImGui::IsItemClicked()) {
+                ImGui::OpenPopup("Filter Select");
             }
             
-            ImGui::SetNextWindowPos(tag_menu_pos);
-            if(ImGui::BeginPopup("Tag Select"))
+            ImGui::SetNextWindowPos(filter_menu_pos);
+            if(ImGui::BeginPopup("Filter Select"))
             {
+                // filters are applied in place, the feed re-filters next frame
                 ImGui::SetWindowFontScale(k_text_size_h2);
-                u32 new_tags = tag_menu(ctx.view->tags);
-                if(new_tags != cur_tags)
-                {
-                    change_view(ctx.view->view, new_tags);
-                }
+                ctx.view->filter = filter_menu(ctx.data_ctx, ctx.view->filter);
                 ImGui::EndPopup();
                 ImGui::SetWindowFontScale(k_text_size_body);
             }
@@ -1095,7 +3694,7 @@ namespace
             static bool back_debounce = false;
             if(lenient_button_click(80.0f, back_debounce))
             {
-                ctx.view = ctx.back_view;
+                change_view(ctx.back_view->view, ctx.back_view->filter);
             }
         }
         else
@@ -1112,7 +3711,7 @@ namespace
         static bool heart_debounce = false;
         if(lenient_button_click(20.0f, heart_debounce))
         {
-            change_view(View::likes, Tags::all);
+            change_view(View::likes, FilterState());
         }
         
         ImGui::SameLine();
@@ -1121,12 +3720,95 @@ namespace
         static bool ellipsis_debounce = false;
         if(lenient_button_click(64.0f, ellipsis_debounce))
         {
-            change_view(View::settings, Tags::all);
+            change_view(View::settings, FilterState());
         }
         
         ImGui::SetWindowFontScale(k_text_size_body);
     }
 
+    // row heights live in a fenwick tree so offsets, updates and appends are all O(log n)
+    f32 row_offset(const std::vector<f32>& tree, size_t count)
+    {
+        // sum of the first count rows
+        f32 sum = 0.0f;
+        for(size_t i = count; i > 0; i -= i & (~i + 1)) {
+            sum += tree[i];
+        }
+        return sum;
+    }
+    
+    void row_update(std::vector<f32>& tree, size_t pos, f32 delta)
+    {
+        for(size_t i = pos + 1; i < tree.size(); i += i & (~i + 1)) {
+            tree[i] += delta;
+        }
+    }
+    
+    void row_append(std::vector<f32>& tree, f32 height)
+    {
+        // node i covers (i - lowbit(i), i]
+        size_t i = tree.size();
+        size_t low = i - (i & (~i + 1));
+        tree.push_back(height + row_offset(tree, i - 1) - row_offset(tree, low));
+    }
+    
+    size_t row_find(const std::vector<f32>& tree, size_t count, f32 y)
+    {
+        // first row whose bottom is below y
+        size_t pos = 0;
+        size_t step = 1;
+        while(step * 2 <= count) {
+            step *= 2;
+        }
+        
+        for(; step > 0; step /= 2)
+        {
+            if(pos + step <= count && tree[pos + step] <= y)
+            {
+                pos += step;
+                y -= tree[pos];
+            }
+        }
+        
+        return pos;
+    }
+    
+    void update_rows(ReleasesView* view)
+    {
+        auto& releases = view->releases;
+        auto& tree = view->row_tree;
+        
+        // rebuild when the selection was rebuilt, otherwise append rows for new entries
+        if(view->row_generation != view->filter_generation || tree.empty())
+        {
+            tree.clear();
+            tree.push_back(0.0f);
+            view->row_count = 0;
+            view->row_generation = view->filter_generation;
+        }
+        
+        for(; view->row_count < view->filtered.size(); ++view->row_count)
+        {
+            u32 r = view->filtered[view->row_count];
+            f32 height = releases.row_height[r] > 0.0f ? releases.row_height[r] : view->row_estimate;
+            row_append(tree, height);
+        }
+    }
+    
+    void measure_row(ReleasesView* view, u32 f, f32 height)
+    {
+        auto& releases = view->releases;
+        u32 r = view->filtered[f];
+        
+        // unmeasured rows use the first measured height as an estimate
+        f32 prev = releases.row_height[r] > 0.0f ? releases.row_height[r] : view->row_estimate;
+        if(abs(height - prev) > 0.5f)
+        {
+            row_update(view->row_tree, f, height - prev);
+        }
+        releases.row_height[r] = height;
+    }
+
     void release_feed()
     {
         f32 w = ctx.w;
@@ -1143,26 +3825,42 @@ namespace
         // Add an empty dummy at the top
         ImGui::Dummy(ImVec2(w, w));
         
+        // apply loads and filter any new entries
+        apply_state_changes(ctx.view);
+        update_filter(ctx.view);
+        
+        if(ctx.view->row_estimate == 0.0f) {
+            ctx.view->row_estimate = w * 1.5f;
+        }
+        update_rows(ctx.view);
+        
+        // rebuilt rows start from estimated heights, so scroll to the anchor row rather than the old offset
+        if(ctx.view->anchor_pos >= 0 && (size_t)ctx.view->anchor_pos < ctx.view->row_count)
+        {
+            ctx.view->scroll.y = row_offset(ctx.view->row_tree, ctx.view->anchor_pos) + ctx.view->anchor_offset;
+            ctx.view->anchor_pos = -1;
+        }
+        
+        // only rows intersecting the viewport plus a margin are laid out
+        f32 rows_top = ImGui::GetCursorPosY();
+        f32 scroll_y = ImGui::GetScrollY();
+        f32 margin = w;
+        size_t row_count = ctx.view->row_count;
+        u32 first = (u32)row_find(ctx.view->row_tree, row_count, std::max(scroll_y - rows_top - margin, 0.0f));
+        
         ctx.top = -1;
-        for(u32 r = 0; r < releases.available_entries; ++r)
+        for(u32 f = first; f < (u32)row_count; ++f)
         {
-            auto title = releases.title[r];
-            auto artist = releases.artist[r];
+            u32 r = ctx.view->filtered[f];
             
-            // apply loads
-            std::atomic_thread_fence(std::memory_order_acquire);
-            if(releases.flags[r] & EntryFlags::artwork_loaded)
-            {
-                if(releases.artwork_texture[r] == 0)
-                {
-                    if(releases.artwork_tcp[r].data)
-                    {
-                        releases.artwork_texture[r] = pen::renderer_create_texture(releases.artwork_tcp[r]);
-                        pen::memory_free(releases.artwork_tcp[r].data); // data is copied for the render thread. safe to delete
-                        releases.artwork_tcp[r].data = nullptr;
-                    }
-                }
+            f32 row_y = rows_top + row_offset(ctx.view->row_tree, f);
+            if(row_y > scroll_y + h + margin) {
+                break;
             }
+            ImGui::SetCursorPosY(row_y);
+
+            const Str& title = releases.title[r];
+            const Str& artist = releases.artist[r];
             
             // select primary
             ImGui::Spacing();
@@ -1174,6 +3872,7 @@ namespace
                     if(ctx.top == -1)
                     {
                         ctx.top = r;
+                        ctx.view->top_pos = f;
                     }
                 }
             }
@@ -1185,45 +3884,45 @@ namespace
             ImGui::SameLine();
             ImGui::TextWrapped("%s: %s", releases.label[r].c_str(), releases.cat[r].c_str());
             
+            // tap label to toggle filtering by it, deferred like urls so a drag starting on it does not filter
+            if(ImGui::IsItemClicked() && !ctx.scroll_lock_x && !ctx.scroll_lock_y)
+            {
+                ctx.label_request = releases.label_id[r];
+                ctx.label_request_counter = 0;
+            }
+            
             ImGui::SetWindowFontScale(k_text_size_body);
             
             // ..
             f32 scaled_vel = ctx.scroll_delta.x;
             
             // images
-            if(releases.artwork_texture[r])
+            f32 aspect = 1.0f;
+            u32 texture = artwork_texture(releases, r, &aspect);
+            if(texture)
             {
-                f32 h = (f32)w * ((f32)releases.artwork_tcp[r].height / (f32)releases.artwork_tcp[r].width);
+                f32 h = (f32)w * aspect;
                 f32 spacing = 20.0f;
                                 
-                ImGui::BeginChildEx("rel", r+1, ImVec2((f32)w, h + 10.0f), false, 0);
-                ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(spacing, 0.0));
+                // one panel per track, the strip is a single item drawn straight to the draw list
+                ImVec2 strip_pos = ImGui::GetCursorScreenPos();
+                ImGui::Dummy(ImVec2((f32)w, h + 10.0f));
                 
                 u32 num_images = std::max<u32>(1, releases.track_url_count[r]);
                 f32 imgw = w + spacing;
                 
                 f32 max_scroll = (num_images * imgw) - imgw;
-                for(u32 i = 0; i < num_images; ++i)
+                if(ImGui::IsItemHovered() && pen::input_is_mouse_down(PEN_MOUSE_L))
                 {
-                    if(i > 0)
-                    {
-                        ImGui::SameLine();
-                    }
-                    
-                    ImGui::Image(IMG(releases.artwork_texture[r]), ImVec2((f32)w, h));
-                    
-                    if(ImGui::IsItemHovered() && pen::input_is_mouse_down(PEN_MOUSE_L))
+                    if(!ctx.scroll_lock_y)
                     {
-                        if(!ctx.scroll_lock_y)
+                        if(abs(ctx.scroll_delta.x) > k_drag_threshold && ctx.side_drag)
                         {
-                            if(abs(ctx.scroll_delta.x) > k_drag_threshold && ctx.side_drag)
-                            {
-                                releases.flags[r] |= EntryFlags::dragging;
-                                ctx.scroll_lock_x = true;
-                            }
-                            
-                            releases.flags[r] |= EntryFlags::hovered;
+                            releases.flags[r] |= EntryFlags::dragging;
+                            ctx.scroll_lock_x = true;
                         }
+                        
+                        releases.flags[r] |= EntryFlags::hovered;
                     }
                 }
                 
@@ -1294,20 +3993,42 @@ namespace
                     releases.flags[r] &= ~EntryFlags::transitioning;
                 }
                 
-                ImGui::SetScrollX(releases.scrollx[r]);
-                
-                ImGui::PopStyleVar();
-                ImGui::EndChild();
+                // emit only the panels intersecting the viewport
+                ImDrawList* draw_list = ImGui::GetWindowDrawList();
+                f32 ssx = releases.scrollx[r];
+                u32 first_panel = (u32)std::max(ssx / imgw, 0.0f);
+                for(u32 i = first_panel; i < num_images; ++i)
+                {
+                    f32 x = strip_pos.x + i * imgw - ssx;
+                    if(x >= strip_pos.x + w) {
+                        break;
+                    }
+                    
+                    draw_list->AddImage(IMG(texture), ImVec2(x, strip_pos.y), ImVec2(x + w, strip_pos.y + h));
+                }
             }
             else
             {
-                // TODO: this is not scrollable
+                // placeholder gradient from the artwork signature, or a flat tone until it is known
+                ImVec2 pos = ImGui::GetCursorScreenPos();
                 ImGui::Dummy(ImVec2(w, w));
+                
+                ImDrawList* draw_list = ImGui::GetWindowDrawList();
+                const ArtworkSignature& sig = releases.artwork_signature[r];
+                if(signature_valid(sig))
+                {
+                    draw_list->AddRectFilledMultiColor(pos, ImVec2(pos.x + w, pos.y + w), sig.corners[0], sig.corners[1], sig.corners[2], sig.corners[3]);
+                }
+                else
+                {
+                    draw_list->AddRectFilled(pos, ImVec2(pos.x + w, pos.y + w), IM_COL32(40, 40, 40, 255));
+                }
             }
             
             // tracks
             ImGui::SetWindowFontScale(k_text_size_dots);
-            s32 tc = releases.track_filepath_count[r];
+            // the state is stored after the paths, so only a cached entry's count and paths are safe to read
+            s32 tc = releases.track_state[r] == EntryState::cached ? releases.track_filepath_count[r] : 0;
             if(tc != 0)
             {
                 auto ww = ImGui::GetWindowSize().x;
@@ -1336,6 +4057,8 @@ namespace
                             {
                                 ctx.play_track_filepath = releases.track_filepaths[r][sel];
                                 ctx.invalidate_track = true;
+                                ctx.audio.view = ctx.view;
+                                ctx.audio.release = r;
                             }
                         }
                         else
@@ -1371,8 +4094,13 @@ namespace
                 ImGui::Text("%s", ICON_FA_HEART);
                 if(lenient_button_click(64.0f, debounce) && !ctx.scroll_lock_x && !ctx.scroll_lock_y)
                 {
+                    // the like may have been stored on any of the linked releases
                     remove_like(releases.id[r]);
+                    for(u32 l = 0; l < releases.store_link_count[r]; ++l) {
+                        remove_like(releases.store_links[r][l].id);
+                    }
                     releases.flags[r] &= ~EntryFlags::liked;
+                    ctx.view->filter_dirty |= ctx.view->filter.liked;
                 }
                 ImGui::PopStyleColor();
             }
@@ -1383,6 +4111,7 @@ namespace
                 {
                     add_like(releases.id[r]);
                     releases.flags[r] |= EntryFlags::liked;
+                    ctx.view->filter_dirty |= ctx.view->filter.liked;
                 }
             }
             ImGui::PopID();
@@ -1404,6 +4133,29 @@ namespace
             }
             ImGui::PopID();
             
+            // buy links for the same release in other stores
+            for(u32 l = 0; l < releases.store_link_count[r]; ++l)
+            {
+                auto& store_link = releases.store_links[r][l];
+                
+                ImGui::SameLine();
+                ImGui::PushID(l + 1);
+                if(store_link.store_tags & StoreTags::preorder)
+                {
+                    ImGui::Text("%s", ICON_FA_CALENDAR_PLUS_O);
+                }
+                else
+                {
+                    ImGui::Text("%s", ICON_FA_CART_PLUS);
+                }
+                
+                if(lenient_button_click(64.0f, debounce) && !ctx.scroll_lock_x && !ctx.scroll_lock_y)
+                {
+                    ctx.open_url_request = store_link.link;
+                }
+                ImGui::PopID();
+            }
+            
             if(releases.store_tags[r] & StoreTags::out_of_stock)
             {
                 ImGui::SameLine();
@@ -1443,157 +4195,415 @@ namespace
             ImGui::Unindent();
             
             ImGui::Spacing();
+            
+            // cache the measured height, later rows shift if it differs from the estimate
+            measure_row(ctx.view, f, ImGui::GetCursorPosY() - row_y);
         }
         
         // couple of empty ones so we can reach the end of the feed
+        f32 rows_height = row_offset(ctx.view->row_tree, row_count);
+        ImGui::SetCursorPosY(rows_top + rows_height);
         ImGui::Dummy(ImVec2(w, w));
         ImGui::Dummy(ImVec2(w, w));
         
-        // get scroll limit
-        ctx.releases_scroll_maxy = ImGui::GetScrollMaxY() - w;
+        // scroll limit from the prefix sums rather than the laid out content
+        f32 content_height = rows_top + rows_height + w * 2.0f;
+        ctx.releases_scroll_maxy = std::max(content_height - ImGui::GetWindowSize().y, 0.0f) - w;
     }
 
+    void close_stream(AudioStream& stream)
+    {
+        if(is_valid(stream.sound))
+        {
+            put::audio_channel_stop(stream.channel);
+            put::audio_release_resource(stream.sound);
+            put::audio_release_resource(stream.channel);
+            put::audio_release_resource(stream.group);
+        }
+        stream = AudioStream();
+    }
+    
+    void open_stream(AudioStream& stream, const Str& filepath, bool preload)
+    {
+        stream.filepath = filepath;
+        stream.sound = put::audio_create_stream(filepath.c_str());
+        stream.channel = put::audio_create_channel_for_sound(stream.sound);
+        stream.group = put::audio_create_channel_group();
+        
+        put::audio_add_channel_to_group(stream.channel, stream.group);
+        put::audio_group_set_volume(stream.group, preload ? 0.0f : 1.0f);
+        put::audio_group_set_pause(stream.group, preload);
+    }
+    
+    void play_stream(AudioPlayer& player, const Str& filepath)
+    {
+        close_stream(player.active);
+        player.started = false;
+        
+        // a preloaded stream is already open and buffered, so it only needs unpausing
+        for(auto& stream : player.preload)
+        {
+            if(is_valid(stream.sound) && stream.filepath == filepath)
+            {
+                player.active = stream;
+                stream = AudioStream();
+                put::audio_group_set_pause(player.active.group, false);
+                put::audio_group_set_volume(player.active.group, 1.0f);
+                return;
+            }
+        }
+        
+        open_stream(player.active, filepath, false);
+    }
+    
+    void preload_streams(AudioPlayer& player)
+    {
+        // the next track of the playing release and the selected track of the releases either side
+        Str candidates[PEN_ARRAY_SIZE(AudioPlayer::preload)];
+        u32 count = 0;
+        
+        auto& releases = ctx.view->releases;
+        auto& filtered = ctx.view->filtered;
+        auto add = [&](u32 r, u32 t) {
+            // only tracks which have finished downloading and are on disk
+            if(releases.track_state[r] == EntryState::cached && t < releases.track_filepath_count[r]) {
+                candidates[count++] = releases.track_filepaths[r][t];
+            }
+        };
+        
+        // only the feed the playing release belongs to knows what comes next
+        if(player.view == ctx.view && ctx.top != -1 && (size_t)ctx.top < releases.available_entries)
+        {
+            u32 pos = ctx.view->top_pos;
+            add(ctx.top, releases.select_track[ctx.top] + 1);
+            if(pos + 1 < filtered.size()) {
+                add(filtered[pos + 1], releases.select_track[filtered[pos + 1]]);
+            }
+            if(pos > 0 && pos - 1 < filtered.size()) {
+                add(filtered[pos - 1], releases.select_track[filtered[pos - 1]]);
+            }
+        }
+        
+        // close streams which are no longer likely to play next
+        for(auto& stream : player.preload)
+        {
+            bool wanted = false;
+            for(u32 c = 0; c < count; ++c) {
+                wanted |= stream.filepath == candidates[c];
+            }
+            
+            if(!wanted) {
+                close_stream(stream);
+            }
+        }
+        
+        // open the missing ones into free slots
+        for(u32 c = 0; c < count; ++c)
+        {
+            bool open = player.active.filepath == candidates[c];
+            AudioStream* free_stream = nullptr;
+            for(auto& stream : player.preload)
+            {
+                open |= is_valid(stream.sound) && stream.filepath == candidates[c];
+                if(!free_stream && !is_valid(stream.sound)) {
+                    free_stream = &stream;
+                }
+            }
+            
+            if(!open && free_stream) {
+                open_stream(*free_stream, candidates[c], true);
+            }
+        }
+    }
+    
     void audio_player()
     {
         auto& releases = ctx.view->releases;
+        auto& player = ctx.audio;
         
         // audio player
         if(!ctx.mute)
         {
-            static u32 si = -1;
-            static u32 ci = -1;
-            static u32 gi = -1;
-            static bool started = false;
-            
             if(ctx.top == -1)
             {
                 // stop existing
-                if(is_valid(si))
+                if(is_valid(player.active.sound))
                 {
-                    // release existing
-                    put::audio_channel_stop(ci);
-                    put::audio_release_resource(si);
-                    put::audio_release_resource(ci);
-                    put::audio_release_resource(gi);
-                    si = -1;
-                    ci = -1;
-                    gi = -1;
-                    started = false;
+                    close_stream(player.active);
+                    player.started = false;
+                    player.view = nullptr;
                     ctx.play_track_filepath = "";
                 }
             }
             
             if(ctx.play_track_filepath.length() > 0 && ctx.invalidate_track)
             {
-                // stop existing
-                if(is_valid(si))
-                {
-                    // release existing
-                    put::audio_channel_stop(ci);
-                    put::audio_release_resource(si);
-                    put::audio_release_resource(ci);
-                    put::audio_release_resource(gi);
-                    si = -1;
-                    ci = -1;
-                    gi = -1;
-                    started = false;
-                }
-                
-                si = put::audio_create_stream(ctx.play_track_filepath.c_str());
-                ci = put::audio_create_channel_for_sound(si);
-                gi = put::audio_create_channel_group();
-                
-                put::audio_add_channel_to_group(ci, gi);
-                put::audio_group_set_volume(gi, 1.0f);
-
+                play_stream(player, ctx.play_track_filepath);
                 ctx.invalidate_track = false;
-                started = false;
             }
             
             // playing
-            if(is_valid(ci))
+            if(is_valid(player.active.channel))
             {
                 put::audio_group_state gstate;
                 memset(&gstate, 0x0, sizeof(put::audio_group_state));
-                put::audio_group_get_state(gi, &gstate);
+                put::audio_group_get_state(player.active.group, &gstate);
                 
-                if(started && gstate.play_state == put::e_audio_play_state::not_playing)
+                if(player.started && gstate.play_state == put::e_audio_play_state::not_playing)
                 {
-                    //
-                    put::audio_channel_stop(ci);
-                    put::audio_release_resource(si);
-                    put::audio_release_resource(ci);
-                    put::audio_release_resource(gi);
-                    si = -1;
-                    ci = -1;
-                    gi = -1;
+                    close_stream(player.active);
                     
-                    // move to next
-                    u32 next = releases.select_track[ctx.top] + 1;
-                    if(next < releases.track_filepath_count[ctx.top])
+                    // move to next, if the feed we started from is still showing that release
+                    if(player.view == ctx.view && player.release == ctx.top)
                     {
-                        ctx.scroll_delta.x = 0.0;
-                        releases.select_track[ctx.top] += 1;
-                        releases.flags[ctx.top] |= EntryFlags::transitioning;
+                        u32 next = releases.select_track[ctx.top] + 1;
+                        if(releases.track_state[ctx.top] == EntryState::cached && next < releases.track_filepath_count[ctx.top])
+                        {
+                            ctx.scroll_delta.x = 0.0;
+                            releases.select_track[ctx.top] += 1;
+                            releases.flags[ctx.top] |= EntryFlags::transitioning;
+                        }
                     }
                 }
                 else if(gstate.play_state == put::e_audio_play_state::playing)
                 {
-                    started = true;
+                    player.started = true;
                 }
             }
+            
+            // only once playback has settled, so flings through the feed do not churn streams
+            if(player.started) {
+                preload_streams(player);
+            }
         }
     }
 
-    void issue_data_requests()
+    // requests made this frame, submitted to the pool in one go
+    std::vector<u32> s_cache_batch;
+    std::vector<u32> s_decode_batch;
+    
+    void window_enter(ReleasesView* view, u32 begin, u32 end, RequestFlags_t request)
     {
-        auto& releases = ctx.view->releases;
+        auto& releases = view->releases;
+        for(u32 f = begin; f < end; ++f)
+        {
+            u32 i = view->filtered[f];
+            if(request == RequestFlags::artwork) {
+                if(releases.artwork_slot[i] == 0) {
+                    releases.request_pos[i] = f;
+                    request_artwork(releases, i, s_decode_batch);
+                }
+                else {
+                    // still resident in the pool, pin it again
+                    releases.requests[i] |= RequestFlags::artwork;
+                }
+            }
+            else {
+                request_cache(releases, i, s_cache_batch);
+            }
+        }
+    }
+    
+    void window_leave(ReleasesView* view, u32 begin, u32 end, RequestFlags_t request)
+    {
+        auto& releases = view->releases;
+        for(u32 f = begin; f < end; ++f)
+        {
+            u32 i = view->filtered[f];
+            if(request == RequestFlags::artwork) {
+                release_artwork(releases, i);
+            }
+            else {
+                cancel_cache(releases, i);
+            }
+        }
+    }
+    
+    void update_window(ReleasesView* view, RequestWindow& window, RequestWindow next, RequestFlags_t request)
+    {
+        // positions leaving the previous range, then positions entering the new one
+        window_leave(view, window.begin, std::min(window.end, next.begin), request);
+        window_leave(view, std::max(window.begin, next.end), window.end, request);
+        window_enter(view, next.begin, std::min(next.end, window.begin), request);
+        window_enter(view, std::max(next.begin, window.end), next.end, request);
+        window = next;
+    }
+    
+    RequestWindow make_window(u32 top, s32 from, s32 to, s32 dir, u32 count)
+    {
+        // from and to are offsets in the scroll direction, flipped into feed positions
+        s32 a = (s32)top + from * dir;
+        s32 b = (s32)top + to * dir;
         
-        // TODO: make the ranges data driven
-        // make requests for data
-        if(ctx.top != -1)
+        RequestWindow window;
+        window.begin = (u32)std::max(std::min(a, b), 0);
+        window.end = (u32)std::max(std::min(std::max(a, b) + 1, (s32)count), 0);
+        window.end = std::max(window.end, window.begin);
+        return window;
+    }
+    
+    void adapt_windows(ReleasesView* view, RequestWindow& artwork, RequestWindow& cache)
+    {
+        auto& releases = view->releases;
+        u32 count = (u32)view->filtered.size();
+        u32 top = view->top_pos;
+        
+        // frame time and scroll speed in rows
+        static u32 s_last_ms = pen::get_time_ms();
+        u32 now = pen::get_time_ms();
+        f32 frame_ms = (f32)std::max<u32>(now - s_last_ms, 1);
+        s_last_ms = now;
+        
+        f32 row_h = std::max(view->row_estimate, 1.0f);
+        f32 rows_per_frame = abs(ctx.scroll_delta.y) / row_h;
+        s32 dir = ctx.scroll_delta.y > 0.0f ? -1 : 1;
+        
+        // a fling decays by the inertia each frame, so it lands roughly a geometric sum of rows away
+        f32 travel = 0.0f;
+        if(!pen::input_is_mouse_down(PEN_MOUSE_L) && !ctx.scroll_lock_x) {
+            travel = rows_per_frame * k_inertia / (1.0f - k_inertia);
+        }
+        
+        // rows passed while a decode is in flight would never be shown
+        f32 decode_frames = (f32)s_decode_ms / frame_ms;
+        f32 skip = std::min(rows_per_frame * decode_frames, travel);
+        
+        // memory caps how many textures the artwork window may hold
+        u32 window_size = std::max<u32>(view->artwork_window.end - view->artwork_window.begin, 1);
+        size_t texture_size = releases.texture_bytes / window_size;
+        u32 artwork_max = k_artwork_window_max;
+        if(texture_size > 0) {
+            artwork_max = (u32)std::min<size_t>(artwork_max, k_artwork_window_budget / texture_size);
+        }
+        artwork_max = std::max(artwork_max, k_artwork_window);
+        
+        // deep look ahead in the direction of travel, a shallow tail behind once moving
+        s32 land = (s32)travel;
+        s32 tail = rows_per_frame > 0.0f ? 1 : (s32)k_artwork_window;
+        s32 art_from = travel > k_artwork_window ? std::max((s32)skip, land - (s32)k_artwork_window) : -tail;
+        s32 art_to = std::min(land + (s32)k_artwork_window, art_from + (s32)artwork_max);
+        artwork = make_window(top, art_from, art_to, dir, count);
+        
+        // slow downloads shrink the prefetch depth so the queue holds what can arrive in time
+        f32 throughput = 1.0f;
+        if(s_artwork_bytes_per_ms > 0) {
+            throughput = std::max(std::min((f32)s_artwork_bytes_per_ms / (f32)k_artwork_bytes_per_ms_target, 1.0f), 0.25f);
+        }
+        
+        s32 cache_tail = rows_per_frame > 0.0f ? (s32)k_artwork_window : (s32)k_cache_window;
+        s32 cache_ahead = std::min(land + (s32)(k_cache_window * throughput), (s32)k_cache_window_max);
+        cache = make_window(top, -cache_tail, cache_ahead, dir, count);
+    }
+
+    void upgrade_artwork(ReleasesView* view)
+    {
+        auto& releases = view->releases;
+        
+        // on screen rows step to medium, the focused row to full when the link is fast and the screen is wide
+        bool slow = s_artwork_bytes_per_ms > 0 && s_artwork_bytes_per_ms * 2 < k_artwork_bytes_per_ms_target;
+        bool wide = view->data_ctx->artwork_width > k_artwork_medium_width;
+        
+        u32 count = (u32)view->filtered.size();
+        u32 begin = view->top_pos > 0 ? view->top_pos - 1 : 0;
+        u32 end = std::min(view->top_pos + 2, count);
+        for(u32 f = begin; f < end; ++f)
         {
-            s32 range_start = max(ctx.top - 10, 0);
-            s32 range_end = min<s32>(ctx.top + 10, (s32)releases.available_entries);
+            u32 i = view->filtered[f];
             
-            for(size_t i = 0; i < releases.available_entries; ++i)
+            // slow links keep thumbnails except for the focused row, so rows are never left blank
+            ArtworkLod_t target = slow ? ArtworkLod::thumb : ArtworkLod::medium;
+            if(f == view->top_pos) {
+                target = (wide && !slow) ? ArtworkLod::full : ArtworkLod::medium;
+            }
+            
+            ArtworkLod_t lod = releases.artwork_lod[i];
+            if(lod >= target || releases.artwork_state[i] != EntryState::uploaded) {
+                continue;
+            }
+            
+            // next level the registry has
+            ArtworkLod_t next = lod + 1;
+            while(next < target && releases.artwork_urls[i].lod[next].empty()) {
+                ++next;
+            }
+            
+            if(releases.artwork_urls[i].lod[next].empty()) {
+                continue;
+            }
+            
+            // the url is written before the state so the worker sees it, the lower level stays drawn meanwhile
+            releases.artwork_url[i] = releases.artwork_urls[i].lod[next];
+            releases.artwork_lod[i] = next;
+            if(state_transition(releases.artwork_state[i], EntryState::uploaded, EntryState::requested))
             {
-                if(i >= range_start && i <= range_end) {
-                    if(releases.artwork_texture[i] == 0) {
-                        releases.flags[i] |= EntryFlags::artwork_requested;
-                    }
-                }
-                else if (releases.flags[i] & EntryFlags::artwork_loaded){
-                    if(releases.artwork_texture[i] != 0) {
-                        // proper release
-                        pen::renderer_release_texture(releases.artwork_texture[i]);
-                        releases.artwork_texture[i] = 0;
-                        releases.flags[i] &= ~EntryFlags::artwork_loaded;
-                        releases.flags[i] &= ~EntryFlags::artwork_requested;
-                    }
-                }
+                releases.requests[i] |= RequestFlags::cache;
+                pool_submit(s_thread_pool, TaskPriority::fetch, cache_release, view, i, &view->pending_tasks);
             }
-            std::atomic_thread_fence(std::memory_order_release);
         }
+    }
+
+    void issue_data_requests()
+    {
+        ReleasesView* view = ctx.view;
+        auto& releases = view->releases;
+        
+        // only entries which newly enter a window are queued to the workers
+        s_cache_batch.clear();
+        s_decode_batch.clear();
         
-        // make requests for cache
+        // make requests for data, ranges are positions in the filtered feed
         if(ctx.top != -1)
         {
-            s32 range_start = max(ctx.top - 100, 0);
-            s32 range_end = min<s32>(ctx.top + 100, (s32)releases.available_entries);
+            u32 count = (u32)view->filtered.size();
+            RequestWindow artwork, cache;
+            adapt_windows(view, artwork, cache);
             
-            for(size_t i = 0; i < releases.available_entries; ++i)
+            // positions are only valid for the selection they were made against, so sweep once when it is rebuilt
+            if(view->window_generation != view->filter_generation)
             {
-                if(i >= range_start && i <= range_end) {
-                    releases.flags[i] |= EntryFlags::cache_url_requested;
-                }
-                else {
-                    releases.flags[i] &= ~EntryFlags::cache_url_requested;
-                    
-                    // TODO: art preloads
-                }
+                window_leave(view, 0, artwork.begin, RequestFlags::artwork);
+                window_leave(view, artwork.end, count, RequestFlags::artwork);
+                window_leave(view, 0, cache.begin, RequestFlags::cache);
+                window_leave(view, cache.end, count, RequestFlags::cache);
+                
+                view->artwork_window = {};
+                view->cache_window = {};
+                view->window_generation = view->filter_generation;
+            }
+            
+            update_window(view, view->artwork_window, artwork, RequestFlags::artwork);
+            update_window(view, view->cache_window, cache, RequestFlags::cache);
+            upgrade_artwork(view);
+        }
+        
+        // visible entries are fetched ahead of the wider prefetch window
+        for(auto& i : s_cache_batch)
+        {
+            TaskPriority_t priority = (releases.requests[i] & RequestFlags::artwork) ? TaskPriority::fetch : TaskPriority::prefetch;
+            pool_submit(s_thread_pool, priority, cache_release, view, i, &view->pending_tasks);
+        }
+        
+        // persist new artwork signatures every few seconds
+        auto& signatures = ctx.data_ctx.signatures;
+        bool save_signatures = false;
+        {
+            std::lock_guard<std::mutex> lock(signatures.mutex);
+            if(signatures.dirty && pen::get_time_ms() - signatures.last_save > 5000)
+            {
+                signatures.dirty = false;
+                signatures.last_save = pen::get_time_ms();
+                save_signatures = true;
             }
         }
+        
+        if(save_signatures) {
+            pool_submit(s_thread_pool, TaskPriority::maintenance, save_signature_index, &signatures, 0);
+        }
+        
+        view->decode_top = view->top_pos;
+        if(!s_decode_batch.empty()) {
+            queue_decodes(view, s_decode_batch.data(), s_decode_batch.size());
+        }
     }
 
     void issue_open_url_requests()
@@ -1622,6 +4632,31 @@ namespace
         }
     }
 
+    void issue_label_requests()
+    {
+        if(ctx.label_request == k_no_label) {
+            return;
+        }
+        
+        // same as urls, a tap which turns into a scroll within 5 frames is dropped
+        if(ctx.scroll_lock_x || ctx.scroll_lock_y)
+        {
+            ctx.label_request = k_no_label;
+            ctx.label_request_counter = 0;
+        }
+        else if(ctx.label_request_counter > 5)
+        {
+            u32 label = ctx.label_request;
+            ctx.view->filter.label = ctx.view->filter.label == label ? k_no_label : label;
+            ctx.label_request = k_no_label;
+            ctx.label_request_counter = 0;
+        }
+        else
+        {
+            ctx.label_request_counter++;
+        }
+    }
+
     void apply_drags()
     {
         f32 w = ctx.w;
@@ -1710,6 +4745,41 @@ namespace
             ImGui::Text("Cached Data: %f(mb)", mb);
         }
         
+        if(ImGui::CollapsingHeader("Uploads"))
+        {
+            auto& stats = ctx.upload_stats;
+            ImGui::Text("Queue Depth: %u", stats.queue_depth);
+            ImGui::Text("Frame: %u / %f(ms)", stats.frame_uploads, stats.frame_ms);
+            ImGui::Text("Max Frame: %f(ms)", stats.max_frame_ms);
+            ImGui::Text("Total: %llu", (unsigned long long)stats.total_uploads);
+        }
+        
+        if(ImGui::CollapsingHeader("Memory"))
+        {
+            auto& memory = ctx.memory;
+            ImGui::Text("Resident: %zu / %zu(mb)", memory.resident_bytes / 1024 / 1024, memory.budget / 1024 / 1024);
+            ImGui::Text("Textures: %zu(kb)", memory.texture_bytes / 1024);
+            ImGui::Text("Staging: %zu(kb)", memory.staging_bytes / 1024);
+            ImGui::Text("Metadata: %zu(kb)", memory.metadata_bytes / 1024);
+            ImGui::Text("Registry: %zu(kb)", memory.registry_bytes / 1024);
+            ImGui::Text("Byte Cache: %zu(kb) %u hits / %u misses", memory.cache_bytes / 1024, ctx.data_ctx.byte_cache.hits, ctx.data_ctx.byte_cache.misses);
+            ImGui::Text("Pressure Events: %u", memory.pressure_events);
+        }
+        
+        if(ImGui::CollapsingHeader("Diagnostics"))
+        {
+            ImGui::Text("Live View Allocations: %lld", (long long)live_view_allocations());
+            
+            // results are logged
+            if(ImGui::Button("Decode Benchmark") && s_benchmark_running.exchange(1) == 0) {
+                pool_submit(s_thread_pool, TaskPriority::maintenance, run_decode_benchmark, &ctx.data_ctx, 0);
+            }
+            
+            if(ImGui::Button("Compression Benchmark") && s_benchmark_running.exchange(1) == 0) {
+                pool_submit(s_thread_pool, TaskPriority::maintenance, run_compression_benchmark, &ctx.data_ctx, 0);
+            }
+        }
+        
         ImGui::SetWindowFontScale(k_text_size_body);
     }
 
@@ -1754,6 +4824,8 @@ namespace
         audio_player();
         issue_data_requests();
         issue_open_url_requests();
+        issue_label_requests();
+        manage_memory();
     }
 
     loop_t user_update()
@@ -1811,13 +4883,20 @@ namespace
                 
         // init context
         ctx.status_bar_height = pen::os_get_status_bar_portrait_height();
+        ctx.artwork_pool.create_texture = renderer_create_texture;
+        ctx.artwork_pool.release_texture = renderer_release_texture;
+        ctx.data_ctx.artwork_width = (u32)ctx.w;
 
+        // shared pool for view, cache and decode work
+        pool_init(s_thread_pool);
+        pool_submit(s_thread_pool, TaskPriority::maintenance, enumerate_cache, &ctx.data_ctx, 0);
+        
         // permanent workers
         pen::thread_create(registry_loader, 10 * 1024 * 1024, &ctx.data_ctx, pen::e_thread_start_flags::detached);
         pen::thread_create(user_data_thread, 10 * 1024 * 1024, ctx.view, pen::e_thread_start_flags::detached);
 
         // enter initial view, the inputs can be serialised
-        change_view(View::latest, Tags::all);
+        change_view(View::latest, FilterState());
 
         // timer
         frame_timer = pen::timer_create();
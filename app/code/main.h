@@ -3,7 +3,6 @@
 // - improve lenient button
 // - fix ratio / scaling of sizes for lenient button
 
-// - placeholder artwork image
 // - drag reload spinner
 
 // - text, sizes and spacing tweaks
@@ -32,6 +31,7 @@
 // - reset chart positions in the new scrape jobs
 
 // DONE
+// x - placeholder artwork image
 // x - move reg to firebase
 // x - parse juno store info
 // x - set min ios version on pen and put
@@ -70,38 +70,113 @@
 
 #include "json.hpp"
 #include <set>
+#include <map>
+#include <new>
+#include <deque>
+#include <list>
+#include <condition_variable>
+#include <thread>
 
 using namespace put::ecs;
 
+// flags owned by the ui thread
 namespace EntryFlags
 {
     enum EntryFlags
     {
         allocated = 1<<0,
-        artwork_cached = 1<<1,
-        tracks_cached = 1<<2,
-        artwork_loaded = 1<<3,
-        tracks_loaded = 1<<4,
         transitioning = 1<<5,
         dragging = 1<<6,
-        artwork_requested = 1<<7,
         liked = 1<<8,
-        hovered = 1<<9,
-        cache_url_requested = 1<<10
+        hovered = 1<<9
     };
 };
 
-namespace Tags
+// requests written only by the ui thread and read by the workers
+namespace RequestFlags
+{
+    enum RequestFlags
+    {
+        artwork = 1<<0,
+        cache = 1<<1
+    };
+};
+typedef u32 RequestFlags_t;
+
+// per release asset state shared between the ui thread and workers, only changed with cas transitions
+namespace EntryState
+{
+    enum EntryState
+    {
+        none,
+        requested,
+        downloading,
+        cached,
+        decoding,
+        decoded,
+        uploaded,
+        evicted
+    };
+};
+typedef u32 EntryState_t;
+
+// artwork sizes provided by the registry, loaded progressively
+namespace ArtworkLod
+{
+    enum ArtworkLod
+    {
+        thumb,      // 150px
+        medium,     // 300px
+        full,
+        count
+    };
+};
+typedef u32 ArtworkLod_t;
+
+// 2x2 low frequency colours of an artwork (tl, tr, br, bl), drawn as a gradient until the texture is ready
+struct ArtworkSignature
+{
+    u32 corners[4];
+};
+
+// decoded image dimensions, compressed textures are padded to whole blocks so tcp is not used for layout
+struct ArtworkSize
+{
+    u32 width = 0;
+    u32 height = 0;
+};
+
+// compressed file bytes shared between the decoder, the async disk write and the ram cache, freed by the last reference
+struct SharedBytes
+{
+    u8*                 data = nullptr;
+    size_t              size = 0;
+    std::atomic<u32>    refs = { 1 };
+    Str                 filepath;
+};
+
+struct ArtworkUrls
+{
+    Str lod[ArtworkLod::count];
+};
+
+// background views give up memory a tier at a time, compact views keep only what is needed to rebuild
+namespace ViewTier
 {
-    enum Tag
+    enum ViewTier
     {
-        techno = 1<<0,
-        electro = 1<<1,
-        house = 1<<2,
-        disco = 1<<3,
-        all = 0xffffffff
+        full,
+        no_textures,
+        no_pixels,
+        compacting,
+        compact
     };
+};
+typedef u32 ViewTier_t;
 
+namespace Tags
+{
+    // legacy fixed tags, releases may still carry these in a "tags" object
     const c8* names[] = {
         "techno",
         "electro",
@@ -109,7 +184,33 @@ namespace Tags
         "disco"
     };
 }
-typedef u32 Tags_t;
+
+// genre tags are loose keys in a release with the value "genre_tag", each unique tag gets a dense bit id
+constexpr u32 k_max_genre_tags = 256;
+constexpr u32 k_tag_words = k_max_genre_tags / 64;
+
+struct TagBits
+{
+    u64 words[k_tag_words] = { 0 };
+};
+
+inline bool operator==(const TagBits& a, const TagBits& b)
+{
+    return memcmp(a.words, b.words, sizeof(a.words)) == 0;
+}
+
+inline bool operator!=(const TagBits& a, const TagBits& b)
+{
+    return !(a == b);
+}
+
+// maps strings (genre tags, store names, labels) to dense ids
+struct StringDictionary
+{
+    std::mutex                  mutex;
+    std::map<std::string, u32>  lookup;
+    std::vector<std::string>    names;
+};
 
 namespace StoreTags
 {
@@ -137,6 +238,72 @@ namespace StoreTags
 }
 typedef u32 StoreTags_t;
 
+// a link to an equivalent release (same label and cat) in another store
+struct StoreLink
+{
+    Str         id;
+    Str         link;
+    u32         store_id;
+    StoreTags_t store_tags;
+};
+
+namespace QueryOp
+{
+    enum QueryOp
+    {
+        all,
+        op_and,
+        op_or,
+        op_not,
+        tags_any,
+        store_tags_all,
+        store_tags_none,
+        store_in,
+        label_id,
+        flags_any
+    };
+}
+typedef u32 QueryOp_t;
+
+struct QueryNode
+{
+    QueryOp_t   op = QueryOp::all;
+    u32         lhs = 0;
+    u32         rhs = 0;
+    u64         value = 0;
+    TagBits     tags = {};
+};
+
+// predicate tree stored flat with children before parents, the last node is the root
+struct Query
+{
+    std::vector<QueryNode>  nodes;
+};
+
+constexpr u32 k_max_stores = 64;
+constexpr u32 k_no_label = 0xffffffff;
+
+struct FilterState
+{
+    TagBits     tags = {};
+    u64         stores = 0; // bit per store id, 0 = any store
+    StoreTags_t require = 0;
+    StoreTags_t exclude = 0;
+    u32         label = k_no_label;
+    bool        liked = false;
+};
+
+inline bool operator==(const FilterState& a, const FilterState& b)
+{
+    return a.tags == b.tags && a.stores == b.stores && a.require == b.require &&
+        a.exclude == b.exclude && a.label == b.label && a.liked == b.liked;
+}
+
+inline bool operator!=(const FilterState& a, const FilterState& b)
+{
+    return !(a == b);
+}
+
 namespace View
 {
     enum View
@@ -177,32 +344,223 @@ namespace DataStatus
 }
 typedef u32 DataStatus_t;
 
+// typed column for the release soa, each column owns its capacity and grows independently
+template<typename T>
+struct soa_column
+{
+    T*      data = nullptr;
+    size_t  capacity = 0;
+    
+    T& operator[](size_t i)
+    {
+        return data[i];
+    }
+    
+    const T& operator[](size_t i) const
+    {
+        return data[i];
+    }
+};
+
+template<typename T>
+void column_relocate(T* dst, T& src)
+{
+    new (dst) T(std::move(src));
+}
+
+template<typename T>
+void column_relocate(std::atomic<T>* dst, std::atomic<T>& src)
+{
+    new (dst) std::atomic<T>(src.load());
+}
+
+template<typename T>
+void column_reserve(soa_column<T>& col, size_t count)
+{
+    if(count <= col.capacity)
+    {
+        return;
+    }
+    
+    // geometric growth, new elements are value initialised (zero for pods)
+    size_t new_capacity = std::max(count, col.capacity * 2);
+    T* new_data = (T*)pen::memory_alloc(sizeof(T) * new_capacity);
+    
+    for(size_t i = 0; i < col.capacity; ++i)
+    {
+        column_relocate(&new_data[i], col.data[i]);
+        col.data[i].~T();
+    }
+    
+    for(size_t i = col.capacity; i < new_capacity; ++i)
+    {
+        new (&new_data[i]) T();
+    }
+    
+    pen::memory_free(col.data);
+    col.data = new_data;
+    col.capacity = new_capacity;
+}
+
+template<typename T>
+void column_free(soa_column<T>& col)
+{
+    for(size_t i = 0; i < col.capacity; ++i)
+    {
+        col.data[i].~T();
+    }
+    
+    pen::memory_free(col.data);
+    col.data = nullptr;
+    col.capacity = 0;
+}
+
 struct soa
 {
-    cmp_array<Str>                          id;
-    cmp_array<u64>                          flags;
-    cmp_array<Str>                          artist;
-    cmp_array<Str>                          title;
-    cmp_array<Str>                          label;
-    cmp_array<Str>                          cat;
-    cmp_array<Str>                          link;
-    cmp_array<Str>                          artwork_url;
-    cmp_array<Str>                          artwork_filepath;
-    cmp_array<u32>                          artwork_texture;
-    cmp_array<pen::texture_creation_params> artwork_tcp;
-    cmp_array<u32>                          track_name_count;
-    cmp_array<Str*>                         track_names;
-    cmp_array<u32>                          track_url_count;
-    cmp_array<Str*>                         track_urls;
-    cmp_array<u32>                          track_filepath_count;
-    cmp_array<Str*>                         track_filepaths;
-    cmp_array<u32>                          select_track;
-    cmp_array<f32>                          scrollx;
-    cmp_array<StoreTags_t>                  store_tags;
-    std::atomic<size_t>                     available_entries = {0};
-    std::atomic<size_t>                     soa_size = {0};
+    // hot: touched every frame by the feed, data requests and loaders
+    soa_column<u64>                             flags;
+    soa_column<std::atomic<u32>>                requests;
+    soa_column<std::atomic<EntryState_t>>       artwork_state;
+    soa_column<std::atomic<EntryState_t>>       track_state;
+    soa_column<u32>                             artwork_slot;
+    soa_column<u32>                             select_track;
+    soa_column<f32>                             scrollx;
+    soa_column<f32>                             row_height;
+    soa_column<u32>                             request_pos;
+    soa_column<ArtworkLod_t>                    artwork_lod;
+    soa_column<ArtworkSignature>                artwork_signature;
+    soa_column<u32>                             track_name_count;
+    soa_column<u32>                             track_url_count;
+    soa_column<u32>                             track_filepath_count;
+    soa_column<StoreTags_t>                     store_tags;
+    soa_column<TagBits>                         genre_tags;
+    soa_column<u32>                             store_id;
+    soa_column<u32>                             label_id;
+    soa_column<u64>                             store_mask;
+    soa_column<u32>                             store_link_count;
+    
+    // cold: only touched when a release is loaded or drawn
+    soa_column<Str>                             id;
+    soa_column<Str>                             artist;
+    soa_column<Str>                             title;
+    soa_column<Str>                             label;
+    soa_column<Str>                             cat;
+    soa_column<Str>                             link;
+    soa_column<Str>                             artwork_url;
+    soa_column<ArtworkUrls>                     artwork_urls;
+    soa_column<Str>                             artwork_filepath;
+    soa_column<pen::texture_creation_params>    artwork_tcp;
+    soa_column<ArtworkSize>                     artwork_size;
+    soa_column<std::atomic<SharedBytes*>>   artwork_bytes;
+    soa_column<Str*>                            track_names;
+    soa_column<Str*>                            track_urls;
+    soa_column<Str*>                            track_filepaths;
+    soa_column<StoreLink*>                      store_links;
+    
+    std::atomic<size_t>                         available_entries = {0};
+    std::atomic<size_t>                         soa_size = {0};
+    
+    // resident artwork memory, used to drive view tiers against the budget
+    std::atomic<size_t>                         texture_bytes = {0};
+    std::atomic<size_t>                         staging_bytes = {0};
+    
+    // compile time column lists, a new column must be added to one of these
+    template<typename F>
+    void visit_hot(F& f)
+    {
+        f(flags);
+        f(requests);
+        f(artwork_state);
+        f(track_state);
+        f(artwork_slot);
+        f(select_track);
+        f(scrollx);
+        f(row_height);
+        f(request_pos);
+        f(artwork_lod);
+        f(artwork_signature);
+        f(track_name_count);
+        f(track_url_count);
+        f(track_filepath_count);
+        f(store_tags);
+        f(genre_tags);
+        f(store_id);
+        f(label_id);
+        f(store_mask);
+        f(store_link_count);
+    }
+    
+    template<typename F>
+    void visit_cold(F& f)
+    {
+        f(id);
+        f(artist);
+        f(title);
+        f(label);
+        f(cat);
+        f(link);
+        f(artwork_url);
+        f(artwork_urls);
+        f(artwork_filepath);
+        f(artwork_tcp);
+        f(artwork_size);
+        f(artwork_bytes);
+        f(track_names);
+        f(track_urls);
+        f(track_filepaths);
+        f(store_links);
+    }
+    
+    template<typename F>
+    void visit(F& f)
+    {
+        visit_hot(f);
+        visit_cold(f);
+    }
+};
+
+// links equivalent releases across stores, keyed on normalised label and cat and confirmed by artwork hashes
+struct DedupeIndex
+{
+    std::mutex                          mutex;
+    std::map<std::string, std::string>  keys;       // release id -> dedupe key
+    std::map<std::string, std::string>  artists;    // release id -> normalised artist
+    std::map<std::string, std::string>  titles;     // release id -> normalised title
+    std::map<std::string, std::string>  stores;     // release id -> store
+    std::map<std::string, std::string>  aliases;    // release id -> dedupe key of the same record in another store
+    std::map<u64, std::string>          artworks;   // quantised artwork signature -> release id
 };
 
+// artwork signatures by release id, persisted next to the cache so placeholders need no network
+struct SignatureIndex
+{
+    std::mutex                              mutex;
+    std::map<std::string, ArtworkSignature> signatures;
+    bool                                    dirty = false;
+    u32                                     last_save = 0;
+};
+
+struct ByteCacheEntry
+{
+    SharedBytes*                        bytes = nullptr;
+    std::list<std::string>::iterator    lru;
+};
+
+// recently used compressed artwork kept in ram in front of the disk cache
+struct ByteCache
+{
+    std::mutex                              mutex;
+    std::map<std::string, ByteCacheEntry>   entries;   // filepath -> bytes
+    std::list<std::string>                  lru;       // most recently used at the front
+    u32                                     generation = 0; // bumped when a file is rewritten, stale reads are not inserted
+    size_t                                  bytes = 0;
+    size_t                                  budget = 32 * 1024 * 1024;
+    u32                                     hits = 0;
+    u32                                     misses = 0;
+};
+
+struct ReleasesView;
+
 struct DataContext
 {
     std::mutex          registry_mutex;
@@ -213,8 +571,179 @@ struct DataContext
     std::atomic<u32>    latest_registry_status = { 0 };
     std::atomic<u32>    user_data_status = { 0 };
     
+    // signalled whenever a registry status changes
+    std::mutex              status_mutex;
+    std::condition_variable status_cv;
+    
+    // info loaders waiting for the cached registry, resubmitted once it is ready
+    std::vector<ReleasesView*> registry_waiters;
+    
     std::atomic<u32>    cached_release_folders = { 0 };
     std::atomic<size_t> cached_release_bytes = { 0 };
+    
+    // size of the registry on disk, the parsed dom is a multiple of this
+    std::atomic<size_t> registry_bytes = { 0 };
+    
+    // width artwork is decoded to, the feed width in pixels
+    u32                 artwork_width = 0;
+    
+    // bumped each time a registry with new content is loaded, views built from an older one are not reused
+    std::atomic<u32>    registry_version = { 0 };
+    size_t              registry_hash = 0;
+    
+    StringDictionary    genre_tags;
+    StringDictionary    stores;
+    StringDictionary    labels;
+    
+    DedupeIndex         dedupe;
+    SignatureIndex      signatures;
+    ByteCache           byte_cache;
+};
+
+namespace TaskPriority
+{
+    enum TaskPriority
+    {
+        decode,         // ui critical artwork decodes
+        fetch,          // downloads for on screen entries and view population
+        prefetch,       // downloads ahead of the viewport
+        maintenance,    // cache stats and cleanup
+        count
+    };
+}
+typedef u32 TaskPriority_t;
+
+typedef void (*TaskFunction)(void* user, u32 index);
+
+struct Task
+{
+    TaskFunction        function = nullptr;
+    void*               user = nullptr;
+    u32                 index = 0;
+    std::atomic<u32>*   counter = nullptr; // decremented when the task completes
+};
+
+// each worker owns a deque per priority, idle workers steal from the back of other workers
+struct WorkerQueue
+{
+    std::mutex          mutex;
+    std::deque<Task>    tasks[TaskPriority::count];
+};
+
+struct ThreadPool
+{
+    WorkerQueue*            workers = nullptr;
+    u32                     num_workers = 0;
+    std::atomic<u32>        next_worker = { 0 };
+    std::atomic<u32>        queued = { 0 };
+    std::mutex              sleep_mutex;
+    std::condition_variable sleep_cv;
+};
+
+// half open range of positions in the filtered feed
+struct RequestWindow
+{
+    u32 begin = 0;
+    u32 end = 0;
+};
+
+// textures are created through function pointers so uploads can run against a stub renderer
+typedef u32 (*CreateTextureFunc)(const pen::texture_creation_params& tcp);
+typedef void (*ReleaseTextureFunc)(u32 texture);
+
+// fixed pool of artwork textures, slots stay resident after a row leaves the window and are reused lru
+struct ArtworkSlot
+{
+    u32     texture = 0;
+    soa*    owner = nullptr;
+    u32     index = 0;
+    u32     last_used = 0;
+    size_t  bytes = 0;
+    u32     width = 0;
+    u32     height = 0;
+};
+
+struct ArtworkPool
+{
+    std::vector<ArtworkSlot>    slots;
+    std::vector<u32>            free_slots;
+    u32                         capacity = 96;
+    CreateTextureFunc           create_texture = nullptr;
+    ReleaseTextureFunc          release_texture = nullptr;
+};
+
+// resident memory across all live views, trimmed to the budget or within a frame of os memory pressure
+struct MemoryBudget
+{
+    size_t              budget = 256 * 1024 * 1024;
+    std::atomic<u32>    pressure = { 0 };
+    
+    // last frame's accounting
+    size_t              texture_bytes = 0;
+    size_t              staging_bytes = 0;
+    size_t              metadata_bytes = 0;
+    size_t              registry_bytes = 0;
+    size_t              cache_bytes = 0;
+    size_t              resident_bytes = 0;
+    u32                 pressure_events = 0;
+};
+
+struct UploadBudget
+{
+    f32     ms = 2.0f;
+    size_t  bytes = 4 * 1024 * 1024;
+};
+
+struct UploadStats
+{
+    u32     queue_depth = 0;
+    u32     frame_uploads = 0;
+    f32     frame_ms = 0.0f;
+    size_t  frame_bytes = 0;
+    f32     max_frame_ms = 0.0f;
+    u64     total_uploads = 0;
+};
+
+struct StateChange
+{
+    u32             index;
+    EntryState_t    state;
+};
+
+// state changes made by workers, consumed by the ui thread
+struct StateQueue
+{
+    std::mutex                  mutex;
+    std::vector<StateChange>    changes;
+};
+
+// per view bump allocator, everything allocated from it is released in one step when the view dies
+struct ArenaBlock
+{
+    ArenaBlock* next;
+    size_t      size;
+    size_t      used;
+};
+
+struct ArenaDestructor
+{
+    void        (*destruct)(void* ptr, size_t count);
+    void*       ptr;
+    size_t      count;
+};
+
+struct ViewArena
+{
+    std::mutex                      mutex;
+    ArenaBlock*                     blocks = nullptr;
+    size_t                          bytes = 0;
+    std::vector<ArenaDestructor>    destructors;
+};
+
+struct DecodeRetry
+{
+    u32 index;
+    u32 due_ms;
 };
 
 struct ReleasesView
@@ -222,12 +751,56 @@ struct ReleasesView
     soa                 releases = {};
     DataContext*        data_ctx = nullptr;
     View_t              view = View::latest;
-    Tags_t              tags = Tags::all;
+    FilterState         filter = {};
     std::atomic<u32>    terminate = { 0 };
-    std::atomic<u32>    threads_terminated = { 0 };
+    std::atomic<u32>    pending_tasks = { 0 };
     u32                 top_pos = 0;
     u32                 reg_timeout = 1000;
     vec2f               scroll = vec2f(0.0f, 0.0f);
+    StateQueue          state_changes;
+    std::vector<u32>    uploads;
+    ViewArena           arena;
+    
+    // artwork waiting to decode, pulled nearest the viewport first by a bounded set of pool tasks
+    std::mutex          decode_mutex;
+    std::vector<u32>    decode_pending;
+    u32                 decode_workers = 0;
+    std::atomic<u32>    decode_top = { 0 };
+    
+    // failed decodes are retried a few times, the file may not have landed on disk yet
+    std::vector<DecodeRetry>    decode_retries;
+    std::map<u32, u32>          decode_failures;
+    
+    // view cache, views are reused while their registry version is current
+    u32                 registry_version = 0;
+    u32                 last_used = 0;
+    ViewTier_t          tier = ViewTier::full;
+    bool                destroy = false;
+    
+    // selection of releases passing the filter, extended as entries arrive and rebuilt when the filter changes
+    std::vector<u32>    filtered = {};
+    size_t              filtered_entries = 0;
+    FilterState         filtered_state = {};
+    Query               query = {};
+    bool                filter_dirty = false;
+    std::vector<u32>    tag_counts = {};
+    size_t              tag_counts_entries = 0;
+    
+    // feed layout, a fenwick tree of row heights over filtered positions
+    std::vector<f32>    row_tree = {};
+    size_t              row_count = 0;
+    u32                 row_generation = 0;
+    u32                 filter_generation = 0;
+    f32                 row_estimate = 0.0f;
+    
+    // scroll position as a row and an offset into it, restored once a rebuilt view has laid that row out
+    s32                 anchor_pos = -1;
+    f32                 anchor_offset = 0.0f;
+    
+    // request windows from the last frame, only entries entering or leaving are touched
+    RequestWindow       artwork_window = {};
+    RequestWindow       cache_window = {};
+    u32                 window_generation = 0;
 };
 
 struct ChartItem
@@ -236,6 +809,26 @@ struct ChartItem
     u32         pos;
 };
 
+// a snippet stream with its channel and group, preloaded ones sit paused and silent until played
+struct AudioStream
+{
+    Str filepath = "";
+    u32 sound = -1;
+    u32 channel = -1;
+    u32 group = -1;
+};
+
+struct AudioPlayer
+{
+    AudioStream active;
+    AudioStream preload[3];
+    bool        started = false;
+    
+    // the feed and release the active stream was started from
+    ReleasesView*   view = nullptr;
+    s32             release = -1;
+};
+
 struct AppContext
 {
     s32                     w, h;
@@ -252,11 +845,18 @@ struct AppContext
     s32                     top = -1;
     Str                     open_url_request = "";
     u32                     open_url_counter = 0;
+    u32                     label_request = k_no_label;
+    u32                     label_request_counter = 0;
     ReleasesView*           view = nullptr;
     ReleasesView*           back_view = nullptr;
     ReleasesView*           reload_view = nullptr;
     DataContext             data_ctx = {};
     std::set<ReleasesView*> background_views = {};
+    ArtworkPool             artwork_pool = {};
+    MemoryBudget            memory = {};
+    AudioPlayer             audio = {};
+    UploadBudget            upload_budget = {};
+    UploadStats             upload_stats = {};
 };
 
 // magic number constants
@@ -273,3 +873,15 @@ constexpr f32 k_text_size_h3 = 1.25f;
 constexpr f32 k_text_size_body = 1.0f;
 constexpr f32 k_text_size_track = 0.75f;
 constexpr f32 k_text_size_dots = 0.8f;
+constexpr u32 k_artwork_window = 10;
+constexpr u32 k_artwork_window_max = 40;
+constexpr u32 k_cache_window = 100;
+constexpr u32 k_cache_window_max = 400;
+constexpr u32 k_artwork_bytes_per_ms_target = 200;
+constexpr u32 k_decode_retries = 3;
+constexpr u32 k_decode_retry_ms = 500;
+constexpr size_t k_artwork_window_budget = 64 * 1024 * 1024;
+constexpr u32 k_artwork_medium_width = 300;
+constexpr u32 k_view_cache_size = 4;
+constexpr size_t k_background_view_budget = 128 * 1024 * 1024;
+constexpr size_t k_low_memory_bytes = 64 * 1024 * 1024;